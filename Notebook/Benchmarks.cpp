@@ -0,0 +1,833 @@
+﻿#include "Benchmarks.h"
+#include "NoteSerializer.h"
+#include "Notebook.h"
+#include "Parallel.h"
+#include "CaseFolding.h"
+#include "FoldedSearch.h"
+#include "EncodingUtils.h"
+#include "CpuFeatures.h"
+#include "TranscodingStreamBuf.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <iterator>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#define BENCHMARK_COUNT_ALLOCATIONS
+#endif
+using namespace std;
+
+// ========== ПОДСЧЁТ ВЫДЕЛЕНИЙ ПАМЯТИ ==========
+
+namespace {
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+    // Выделения за время замера; перехватчик отладочной CRT ставится только на этот срок,
+    // распределитель памяти программы не заменяется
+    atomic<size_t> allocationCount{ 0 };
+
+    int countingAllocHook(int allocType, void*, size_t, int, long, const unsigned char*, int) {
+        if (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC) {
+            allocationCount.fetch_add(1, memory_order_relaxed);
+        }
+        return 1;  // Выделение разрешено
+    }
+#endif
+
+    // Число выделений памяти за время выполнения функции
+    // Считается только в отладочной сборке MSVC, иначе функция просто выполняется
+    template <typename Func>
+    size_t countAllocations(Func func) {
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+        size_t before = allocationCount.load(memory_order_relaxed);
+        _CRT_ALLOC_HOOK previous = _CrtSetAllocHook(countingAllocHook);
+        func();
+        _CrtSetAllocHook(previous);
+        return allocationCount.load(memory_order_relaxed) - before;
+#else
+        func();
+        return 0;
+#endif
+    }
+
+    // Число выделений для вывода (с долей на заметку, если perNote не 0)
+    string allocationsText(size_t count, size_t perNote = 0) {
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+        ostringstream text;
+        text << count;
+        if (perNote != 0) {
+            text << " (" << (double)count / (double)perNote << " на заметку)";
+        }
+        return text.str();
+#else
+        (void)count;
+        (void)perNote;
+        return "н/д (считаются только в отладочной сборке)";
+#endif
+    }
+
+    const char* BENCHMARK_TEXT_FILE = "benchmark_notes.txt";
+
+    // Время выполнения функции в миллисекундах
+    template <typename Func>
+    double measureMs(Func func) {
+        auto start = chrono::steady_clock::now();
+        func();
+        auto finish = chrono::steady_clock::now();
+        return chrono::duration<double, milli>(finish - start).count();
+    }
+
+    // Синтетическая заметка: повторяющиеся авторы и теги, смешанный русский/английский текст
+    Note makeSyntheticNote(size_t i) {
+        static const char* authors[] = { "Катя", "Боб", "Анна", "Иван", "alice", "bob" };
+        static const char* words[] = { "проект", "встреча", "отчёт", "покупки", "release",
+            "deadline", "идея", "book", "рецепт", "план" };
+        static const char* tags[] = { "работа", "дом", "личное", "идеи", "work", "todo" };
+
+        string title = string(words[i % 10]) + " " + to_string(i);
+        string content;
+        for (size_t w = 0; w < 24; ++w) {
+            content += words[(i + w * 7) % 10];
+            content += ' ';
+        }
+
+        Note note(authors[i % 6], title, content);
+        note.setTags({ tags[i % 6], tags[(i / 6) % 6] });
+        note.setCreatedTime((time_t)(1700000000 + i * 60));
+        note.setUpdatedTime((time_t)(1700000000 + i * 60));
+        return note;
+    }
+
+} // namespace
+
+size_t Benchmarks::writeSyntheticTextFile(const char* path, size_t noteCount) {
+    ofstream file(path, ios::binary);
+    if (!file.is_open()) {
+        throw runtime_error(string("Cannot open file for writing: ") + path);
+    }
+
+    // Пишем порциями, чтобы не держать в памяти весь набор заметок
+    const size_t batchSize = 10000;
+    vector<Note> batch;
+    for (size_t i = 0; i < noteCount; i += batchSize) {
+        batch.clear();
+        for (size_t j = i; j < noteCount && j < i + batchSize; ++j) {
+            batch.push_back(makeSyntheticNote(j));
+        }
+        NoteSerializer::writeText(file, batch);
+    }
+
+    return (size_t)file.tellp();
+}
+
+void Benchmarks::runTextLoad(size_t noteCount) {
+    cout << "\n=== ЗАГРУЗКА ТЕКСТОВОГО ФОРМАТА ===" << endl;
+    size_t fileSize = writeSyntheticTextFile(BENCHMARK_TEXT_FILE, noteCount);
+    cout << "Файл: " << noteCount << " заметок, " << fileSize / (1024 * 1024) << " МБ" << endl;
+
+    // Результаты держим вне замера, чтобы не учитывать освобождение заметок
+    vector<Note> streamNotes;
+    double streamMs = measureMs([&]() {
+        ifstream file(BENCHMARK_TEXT_FILE);
+        streamNotes = NoteSerializer::readText(file);
+    });
+    size_t streamCount = streamNotes.size();
+    streamNotes = vector<Note>();
+
+    vector<Note> bufferNotes;
+    double bufferMs = measureMs([&]() {
+        ifstream file(BENCHMARK_TEXT_FILE, ios::binary);
+        string buffer(fileSize, '\0');
+        file.read(&buffer[0], (streamsize)fileSize);
+        bufferNotes = NoteSerializer::readText(buffer.data(), (size_t)file.gcount());
+    });
+    size_t bufferCount = bufferNotes.size();
+    bufferNotes = vector<Note>();
+
+    unsigned threads = Parallel::workerCount();
+    vector<Note> parallelNotes;
+    double parallelMs = measureMs([&]() {
+        ifstream file(BENCHMARK_TEXT_FILE, ios::binary);
+        string buffer(fileSize, '\0');
+        file.read(&buffer[0], (streamsize)fileSize);
+        parallelNotes = NoteSerializer::readTextParallel(buffer.data(), (size_t)file.gcount(), threads);
+    });
+    size_t parallelCount = parallelNotes.size();
+    parallelNotes = vector<Note>();
+
+    cout << "Построчное чтение (getline/substr): " << streamMs << " мс, заметок: " << streamCount << endl;
+    cout << "Разбор буфера (string_view):       " << bufferMs << " мс, заметок: " << bufferCount << endl;
+    cout << "Параллельный разбор (" << threads << " потоков):   " << parallelMs << " мс, заметок: " << parallelCount << endl;
+    if (bufferMs > 0 && parallelMs > 0) {
+        cout << "Ускорение: буфер " << streamMs / bufferMs << "x, параллельно " << streamMs / parallelMs << "x" << endl;
+    }
+    if (streamCount != bufferCount || streamCount != parallelCount) {
+        cout << "! Результаты загрузчиков не совпадают" << endl;
+    }
+
+    remove(BENCHMARK_TEXT_FILE);
+}
+
+void Benchmarks::runBulkRemove(size_t noteCount) {
+    cout << "\n=== МАССОВОЕ УДАЛЕНИЕ ===" << endl;
+
+    // Прежний путь квадратичен, поэтому замеряется на ограниченном числе заметок
+    size_t eraseCount = (std::min)(noteCount, (size_t)20000);
+    vector<Note> plain;
+    plain.reserve(eraseCount);
+    for (size_t i = 0; i < eraseCount; ++i) {
+        plain.push_back(makeSyntheticNote(i));
+    }
+    double eraseMs = measureMs([&]() {
+        while (!plain.empty()) {
+            plain.erase(plain.begin());
+        }
+    });
+
+    Notebook notebook;
+    vector<NoteId> ids;
+    ids.reserve(noteCount);
+    for (size_t i = 0; i < noteCount; ++i) {
+        ids.push_back(notebook.addNote(makeSyntheticNote(i)));
+    }
+
+    // Сначала каждая вторая заметка, затем остальные - надгробия и несколько уплотнений
+    double tombstoneMs = measureMs([&]() {
+        for (size_t i = 0; i < ids.size(); i += 2) notebook.removeNoteById(ids[i]);
+        for (size_t i = 1; i < ids.size(); i += 2) notebook.removeNoteById(ids[i]);
+    });
+
+    cout << "vector::erase с начала, " << eraseCount << " заметок: " << eraseMs << " мс" << endl;
+    cout << "Надгробия и уплотнение, " << noteCount << " заметок: " << tombstoneMs << " мс" << endl;
+    if (notebook.getNoteCount() != 0) {
+        cout << "! После удаления остались заметки: " << notebook.getNoteCount() << endl;
+    }
+}
+
+void Benchmarks::runSearchAllocations(size_t noteCount) {
+    cout << "\n=== ВЫДЕЛЕНИЯ ПАМЯТИ ПРИ ПОИСКЕ ===" << endl;
+
+    Notebook notebook;
+    for (size_t i = 0; i < noteCount; ++i) {
+        notebook.addNote(makeSyntheticNote(i));
+    }
+    const string word = "проект";
+    const string foldedWord = CaseFolding::toLowerCp1251(word);
+
+    // Прежний путь: поля копируются геттерами по значению и ещё раз при приведении регистра
+    size_t legacyMatches = 0;
+    size_t legacyAllocations = 0;
+    double legacyMs = measureMs([&]() {
+        legacyAllocations = countAllocations([&]() {
+            for (int i = 0; i < notebook.getNoteCount(); ++i) {
+                const Note* note = notebook.getNote(i);
+                string content = CaseFolding::toLowerCp1251(string(note->getContent()));
+                string title = CaseFolding::toLowerCp1251(string(note->getTitle()));
+                if (content.find(foldedWord) != string::npos || title.find(foldedWord) != string::npos) {
+                    ++legacyMatches;
+                }
+            }
+        });
+    });
+
+    vector<int> found;
+    size_t wordAllocations = 0;
+    double wordMs = measureMs([&]() {
+        wordAllocations = countAllocations([&]() { found = notebook.findByWord(word); });
+    });
+    size_t wordMatches = found.size();
+
+    size_t authorAllocations = countAllocations([&]() { found = notebook.findByAuthor("анна"); });
+    size_t tagAllocations = countAllocations([&]() { found = notebook.findByTag("работа"); });
+
+    // Выделения, не зависящие от числа заметок: образец в нижнем регистре и рост вектора результата
+    cout << "Копирующий просмотр: " << legacyMs << " мс, выделений "
+        << allocationsText(legacyAllocations, (max)(noteCount, (size_t)1)) << endl;
+    cout << "findByWord по ссылкам: " << wordMs << " мс, выделений "
+        << allocationsText(wordAllocations, (max)(noteCount, (size_t)1)) << endl;
+    cout << "findByAuthor: выделений " << allocationsText(authorAllocations)
+        << ", findByTag: выделений " << allocationsText(tagAllocations) << endl;
+    cout << "Выделения по ссылкам приходятся только на вектор результата и образец поиска" << endl;
+    if (legacyMatches != wordMatches) {
+        cout << "! Результаты поиска не совпадают: " << legacyMatches << " и " << wordMatches << endl;
+    }
+}
+
+void Benchmarks::runColumnScan(size_t noteCount) {
+    cout << "\n=== ПРОСМОТР ОДНОГО ПОЛЯ ===" << endl;
+
+    vector<Note> notes;
+    notes.reserve(noteCount);
+    for (size_t i = 0; i < noteCount; ++i) {
+        notes.push_back(makeSyntheticNote(i));
+    }
+    // Столбцы (struct-of-arrays) только для замера: Notebook хранит объекты Note
+    vector<time_t> createdColumn;
+    vector<SymbolId> authorColumn;
+    createdColumn.reserve(notes.size());
+    authorColumn.reserve(notes.size());
+    for (const auto& note : notes) {
+        createdColumn.push_back(note.getCreatedTime());
+        authorColumn.push_back(note.getAuthorId());
+    }
+
+    // Последняя десятая часть заметок по времени создания
+    time_t from = (time_t)(1700000000 + (noteCount - noteCount / 10) * 60);
+    time_t to = (numeric_limits<time_t>::max)();
+    const string author = "Анна";
+    const int repeats = 20;
+
+    size_t objectRows = 0, columnRows = 0;
+    double objectTimeMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            objectRows = 0;
+            for (const auto& note : notes) {
+                if (note.getCreatedTime() >= from && note.getCreatedTime() < to) ++objectRows;
+            }
+        }
+    });
+    double columnTimeMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            columnRows = 0;
+            for (time_t created : createdColumn) {
+                if (created >= from && created < to) ++columnRows;
+            }
+        }
+    });
+
+    size_t objectAuthorRows = 0, columnAuthorRows = 0;
+    double objectAuthorMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            objectAuthorRows = 0;
+            for (const auto& note : notes) {
+                if (note.getAuthor() == author) ++objectAuthorRows;
+            }
+        }
+    });
+    double columnAuthorMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            int64_t authorId = SymbolTable::authors().find(author);
+            columnAuthorRows = authorId < 0 ? 0 : (size_t)count(authorColumn.begin(), authorColumn.end(), (SymbolId)authorId);
+        }
+    });
+
+    cout << "Время создания, " << repeats << " проходов: объекты Note " << objectTimeMs
+        << " мс, столбец " << columnTimeMs << " мс (байт на строку: " << sizeof(Note)
+        << " против " << sizeof(time_t) << ")" << endl;
+    cout << "Автор, " << repeats << " проходов: сравнение строк " << objectAuthorMs
+        << " мс, столбец идентификаторов " << columnAuthorMs << " мс" << endl;
+    if (objectRows != columnRows || objectAuthorRows != columnAuthorRows) {
+        cout << "! Результаты просмотра не совпадают" << endl;
+    }
+}
+
+void Benchmarks::runTagQuery(size_t noteCount) {
+    cout << "\n=== ЗАПРОС ПО НАБОРУ ТЕГОВ ===" << endl;
+
+    Notebook notebook;
+    for (size_t i = 0; i < noteCount; ++i) {
+        notebook.addNote(makeSyntheticNote(i));
+    }
+    const vector<string> all = { "работа", "todo" };
+    const vector<string> none = { "дом" };
+    const int repeats = 20;
+
+    // Прежний путь: просмотр всех заметок на каждый тег и пересечение векторов индексов
+    size_t legacyRows = 0;
+    double legacyMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            vector<int> result = notebook.findByTag(all[0], TagMatch::Exact);
+            vector<int> second = notebook.findByTag(all[1], TagMatch::Exact);
+            vector<int> excluded = notebook.findByTag(none[0], TagMatch::Exact);
+            vector<int> both, kept;
+            set_intersection(result.begin(), result.end(), second.begin(), second.end(), back_inserter(both));
+            set_difference(both.begin(), both.end(), excluded.begin(), excluded.end(), back_inserter(kept));
+            legacyRows = kept.size();
+        }
+    });
+
+    size_t indexRows = 0;
+    double indexMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            indexRows = notebook.findIdsByTags(all, {}, none).size();
+        }
+    });
+
+    cout << "Теги 'работа' и 'todo' без 'дом', " << repeats << " запросов: пересечение векторов "
+        << legacyMs << " мс, findByTags " << indexMs << " мс, заметок " << indexRows << endl;
+    if (legacyRows != indexRows) {
+        cout << "! Результаты запросов не совпадают: " << legacyRows << " и " << indexRows << endl;
+    }
+}
+
+void Benchmarks::runTrigramSearch(size_t noteCount) {
+    cout << "\n=== ПОИСК ПОДСТРОКИ ПО ТРИГРАММАМ ===" << endl;
+
+    Notebook notebook;
+    double buildMs = measureMs([&]() {
+        for (size_t i = 0; i < noteCount; ++i) {
+            notebook.addNote(makeSyntheticNote(i));
+        }
+    });
+    cout << "Добавление " << noteCount << " заметок с обновлением индексов: " << buildMs << " мс" << endl;
+
+    // Редкая подстрока (номер в заголовке одной заметки) и частая (слово из большинства заметок)
+    const string rare = to_string(noteCount / 2 + 7) + " ";
+    const string queries[] = { rare.substr(0, rare.size() - 1), "DEADL", "оект" };
+    const int repeats = 10;
+
+    for (const auto& query : queries) {
+        string folded = CaseFolding::toLowerCp1251(query);
+
+        size_t scanRows = 0;
+        double scanMs = measureMs([&]() {
+            for (int r = 0; r < repeats; ++r) {
+                scanRows = 0;
+                for (int i = 0; i < notebook.getNoteCount(); ++i) {
+                    const Note* note = notebook.getNote(i);
+                    if (CaseFolding::containsFoldedCp1251(note->getContent(), folded) ||
+                        CaseFolding::containsFoldedCp1251(note->getTitle(), folded)) {
+                        ++scanRows;
+                    }
+                }
+            }
+        });
+
+        size_t indexRows = 0;
+        double indexMs = measureMs([&]() {
+            for (int r = 0; r < repeats; ++r) {
+                indexRows = notebook.findIdsByWord(query).size();
+            }
+        });
+
+        cout << "'" << query << "', " << repeats << " запросов: полный просмотр " << scanMs
+            << " мс, триграммы " << indexMs << " мс, заметок " << indexRows << endl;
+        if (scanRows != indexRows) {
+            cout << "! Результаты поиска не совпадают: " << scanRows << " и " << indexRows << endl;
+        }
+    }
+}
+
+void Benchmarks::runFoldedSearch(size_t noteCount) {
+    cout << "\n=== ЯДРА РЕГИСТРОНЕЗАВИСИМОГО ПОИСКА ===" << endl;
+
+    vector<Note> notes;
+    notes.reserve(noteCount);
+    size_t textBytes = 0;
+    for (size_t i = 0; i < noteCount; ++i) {
+        notes.push_back(makeSyntheticNote(i));
+        textBytes += notes.back().getContent().size();
+    }
+
+    // Образца нет в тексте - каждое ядро просматривает всё содержимое до конца
+    const string folded = CaseFolding::toLowerCp1251("Отчёт за квартал");
+    const int repeats = 5;
+    cout << "Содержимое: " << textBytes / 1024 << " КБ, " << repeats << " проходов, ядро по умолчанию: "
+        << FoldedSearch::kernelName(FoldedSearch::activeKernel()) << endl;
+
+    // Прежний путь: копия в нижнем регистре и std::string::find
+    size_t legacyRows = 0;
+    double legacyMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            legacyRows = 0;
+            for (const auto& note : notes) {
+                if (CaseFolding::toLowerCp1251(note.getContent()).find(folded) != string::npos) ++legacyRows;
+            }
+        }
+    });
+    cout << "Копия + find:   " << legacyMs << " мс" << endl;
+
+    const FoldedSearch::Kernel kernels[] = {
+        FoldedSearch::Kernel::Scalar, FoldedSearch::Kernel::Sse2, FoldedSearch::Kernel::Avx2 };
+    for (FoldedSearch::Kernel kernel : kernels) {
+        if (!FoldedSearch::isSupported(kernel)) {
+            cout << FoldedSearch::kernelName(kernel) << ": не поддерживается" << endl;
+            continue;
+        }
+
+        size_t rows = 0;
+        double kernelMs = measureMs([&]() {
+            for (int r = 0; r < repeats; ++r) {
+                rows = 0;
+                for (const auto& note : notes) {
+                    if (FoldedSearch::find(note.getContent(), folded, kernel) != FoldedSearch::npos) ++rows;
+                }
+            }
+        });
+        double gbPerSecond = kernelMs > 0 ? (double)textBytes * repeats / (kernelMs * 1e6) : 0;
+        cout << FoldedSearch::kernelName(kernel) << ": " << kernelMs << " мс (" << gbPerSecond << " ГБ/с)" << endl;
+        if (rows != legacyRows) {
+            cout << "! Результаты ядра не совпадают: " << rows << " и " << legacyRows << endl;
+        }
+    }
+}
+
+void Benchmarks::runFoldedCache(size_t noteCount) {
+    cout << "\n=== ТЕНЕВЫЕ КОПИИ В НИЖНЕМ РЕГИСТРЕ ===" << endl;
+
+    Notebook notebook;
+    for (size_t i = 0; i < noteCount; ++i) {
+        notebook.addNote(makeSyntheticNote(i));
+    }
+
+    // Короткий запрос индекс триграмм не сужает - это полный просмотр
+    const string query = "Щы";
+    const string folded = CaseFolding::toLowerCp1251(query);
+    const int repeats = 5;
+
+    // Приведение регистра на лету при каждом запросе
+    size_t kernelRows = 0;
+    double kernelMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            kernelRows = 0;
+            for (int i = 0; i < notebook.getNoteCount(); ++i) {
+                const Note* note = notebook.getNote(i);
+                if (FoldedSearch::contains(note->getContent(), folded) ||
+                    FoldedSearch::contains(note->getTitle(), folded)) {
+                    ++kernelRows;
+                }
+            }
+        }
+    });
+
+    size_t firstRows = 0, repeatRows = 0;
+    double firstMs = measureMs([&]() { firstRows = notebook.findByWord(query).size(); });
+    double repeatMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) repeatRows = notebook.findByWord(query).size();
+    });
+
+    cout << "Приведение на лету, " << repeats << " запросов: " << kernelMs << " мс" << endl;
+    cout << "findByWord: первый запрос (заполняет копии) " << firstMs << " мс, ещё "
+        << repeats << " запросов " << repeatMs << " мс" << endl;
+    if (kernelRows != firstRows || firstRows != repeatRows) {
+        cout << "! Результаты поиска не совпадают" << endl;
+    }
+}
+
+void Benchmarks::runParallelScan(size_t noteCount) {
+    cout << "\n=== ПАРАЛЛЕЛЬНЫЙ ПОЛНЫЙ ПРОСМОТР ===" << endl;
+
+    Notebook notebook;
+    for (size_t i = 0; i < noteCount; ++i) {
+        notebook.addNote(makeSyntheticNote(i));
+    }
+
+    // Короткий запрос и подстрока автора индексами не обслуживаются - это полный просмотр
+    const string word = "Щы";
+    const string author = "н";
+    const int repeats = 5;
+    vector<int> serialWord, serialAuthor, parallelWord, parallelAuthor;
+
+    // Теневые копии заполняются заранее, чтобы первый замер не платил за них
+    notebook.findByWord(word);
+
+    notebook.setParallelScanThreshold((numeric_limits<size_t>::max)());
+    double serialMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            serialWord = notebook.findByWord(word);
+            serialAuthor = notebook.findByAuthor(author);
+        }
+    });
+
+    notebook.setParallelScanThreshold(0);
+    double parallelMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            parallelWord = notebook.findByWord(word);
+            parallelAuthor = notebook.findByAuthor(author);
+        }
+    });
+
+    cout << "Потоков: " << Parallel::workerCount() << ", " << repeats << " пар запросов" << endl;
+    cout << "Последовательно: " << serialMs << " мс, параллельно: " << parallelMs << " мс" << endl;
+    if (serialWord != parallelWord || serialAuthor != parallelAuthor) {
+        cout << "! Результаты поиска не совпадают" << endl;
+    }
+}
+
+void Benchmarks::runRankedSearch(size_t noteCount) {
+    cout << "\n=== РАНЖИРОВАННЫЙ ПОИСК (BM25) ===" << endl;
+
+    Notebook notebook;
+    for (size_t i = 0; i < noteCount; ++i) {
+        notebook.addNote(makeSyntheticNote(i));
+    }
+
+    // Слова синтетического текста встречаются почти в каждой заметке - худший случай для выдачи
+    const string query = "проект deadline";
+    const size_t k = 10;
+    const int repeats = 5;
+
+    size_t allRows = 0;
+    double allMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) allRows = notebook.findByWord(query, WordMatch::WholeWord).size();
+    });
+
+    vector<ScoredNote> top;
+    double topMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) top = notebook.findTopIdsByWord(query, k);
+    });
+
+    cout << "Все совпадения: " << allRows << " заметок, " << repeats << " запросов " << allMs << " мс" << endl;
+    cout << "Лучшие " << k << ": " << repeats << " запросов " << topMs << " мс";
+    if (!top.empty()) cout << ", оценка от " << top.front().score << " до " << top.back().score;
+    cout << endl;
+    if (top.size() != (std::min)(k, allRows)) {
+        cout << "! Неверное число лучших совпадений" << endl;
+    }
+}
+
+#ifdef _WIN32
+namespace {
+
+    // Прежняя перекодировка через UTF-16 средствами Win32 - точка отсчёта для сравнения
+    string win32Transcode(const string& text, UINT from, UINT to) {
+        int wsize = MultiByteToWideChar(from, 0, text.data(), (int)text.size(), NULL, 0);
+        vector<wchar_t> wide((size_t)wsize);
+        MultiByteToWideChar(from, 0, text.data(), (int)text.size(), wide.data(), wsize);
+        int size = WideCharToMultiByte(to, 0, wide.data(), wsize, NULL, 0, NULL, NULL);
+        string result((size_t)size, '\0');
+        WideCharToMultiByte(to, 0, wide.data(), wsize, &result[0], size, NULL, NULL);
+        return result;
+    }
+
+} // namespace
+#endif
+
+void Benchmarks::runTranscode(size_t noteCount) {
+    cout << "\n=== ПЕРЕКОДИРОВКА CP-1251 <-> UTF-8 ===" << endl;
+
+    // Поля синтетических заметок: смесь русского и английского текста
+    vector<string> fields;
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < noteCount; ++i) {
+        Note note = makeSyntheticNote(i);
+        fields.push_back(note.getTitle());
+        fields.push_back(note.getContent());
+        totalBytes += note.getTitle().size() + note.getContent().size();
+    }
+
+    vector<string> utf8(fields.size());
+    double toUtf8Ms = measureMs([&]() {
+        for (size_t i = 0; i < fields.size(); ++i) utf8[i] = EncodingUtils::cp1251_to_utf8(fields[i]);
+    });
+    size_t mismatches = 0;
+    double toCp1251Ms = measureMs([&]() {
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (EncodingUtils::utf8_to_cp1251(utf8[i]) != fields[i]) ++mismatches;
+        }
+    });
+
+    double megabytes = (double)totalBytes / (1024.0 * 1024.0);
+    cout << "Полей: " << fields.size() << ", " << megabytes << " МБ в CP-1251" << endl;
+    cout << "Таблицы: CP-1251 -> UTF-8 " << toUtf8Ms << " мс (" << megabytes / toUtf8Ms * 1000.0
+        << " МБ/с), UTF-8 -> CP-1251 " << toCp1251Ms << " мс" << endl;
+
+    // Тот же текст одним буфером в заранее выделенный выход - скорость без выделений памяти
+    string joined;
+    joined.reserve(totalBytes);
+    for (const auto& field : fields) joined += field;
+    string output(joined.size() * EncodingUtils::MAX_UTF8_PER_CP1251, '\0');
+    size_t written = 0;
+    double bufferMs = measureMs([&]() {
+        written = EncodingUtils::cp1251_to_utf8(joined.data(), joined.size(), &output[0]);
+    });
+    cout << "Одним буфером: CP-1251 -> UTF-8 " << bufferMs << " мс (" << megabytes / bufferMs * 1000.0
+        << " МБ/с), " << written << " байт" << endl;
+
+#ifdef _WIN32
+    size_t win32Mismatches = 0;
+    double win32Ms = measureMs([&]() {
+        for (size_t i = 0; i < fields.size(); ++i) {
+            string converted = win32Transcode(fields[i], 1251, CP_UTF8);
+            if (win32Transcode(converted, CP_UTF8, 1251) != fields[i]) ++win32Mismatches;
+        }
+    });
+    cout << "Win32 через UTF-16, туда и обратно: " << win32Ms << " мс" << endl;
+    mismatches += win32Mismatches;
+#endif
+
+    if (mismatches != 0) {
+        cout << "! Перекодировка туда и обратно изменила " << mismatches << " полей" << endl;
+    }
+}
+
+void Benchmarks::runUtf8Validation(size_t noteCount) {
+    cout << "\n=== ПРОВЕРКА UTF-8 ===" << endl;
+
+    string text;
+    for (size_t i = 0; i < noteCount; ++i) {
+        Note note = makeSyntheticNote(i);
+        text += EncodingUtils::cp1251_to_utf8(note.getTitle());
+        text += EncodingUtils::cp1251_to_utf8(note.getContent());
+    }
+    const int repeats = 5;
+
+    bool scalarValid = false, vectorValid = false;
+    double scalarMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) scalarValid = EncodingUtils::is_valid_utf8_scalar(text.data(), text.size());
+    });
+    double vectorMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) vectorValid = EncodingUtils::is_valid_utf8(text.data(), text.size());
+    });
+
+    double megabytes = (double)text.size() * repeats / (1024.0 * 1024.0);
+    cout << "Текст: " << text.size() / (1024 * 1024) << " МБ UTF-8, " << repeats << " проходов" << endl;
+    cout << "Последовательный разбор: " << scalarMs << " мс (" << megabytes / scalarMs * 1000.0 << " МБ/с)" << endl;
+    cout << "По таблицам (" << (CpuFeatures::hasAvx2() ? "AVX2" : "без AVX2 - последовательно") << "): "
+        << vectorMs << " мс (" << megabytes / vectorMs * 1000.0 << " МБ/с)" << endl;
+    if (!scalarValid || !vectorValid) {
+        cout << "! Корректный текст признан ошибочным" << endl;
+    }
+}
+
+void Benchmarks::runStreamingTranscode(size_t noteCount) {
+    cout << "\n=== ЗАГРУЗКА CP-1251 КАК UTF-8 ===" << endl;
+    size_t fileSize = writeSyntheticTextFile(BENCHMARK_TEXT_FILE, noteCount);
+    cout << "Файл: " << noteCount << " заметок, " << fileSize / (1024 * 1024) << " МБ" << endl;
+
+    // Прежний путь: разбор в CP-1251, затем каждая строка каждой заметки перекодируется отдельно
+    vector<Note> fieldNotes;
+    double fieldMs = measureMs([&]() {
+        ifstream file(BENCHMARK_TEXT_FILE, ios::binary);
+        string buffer(fileSize, '\0');
+        file.read(&buffer[0], (streamsize)fileSize);
+        fieldNotes = NoteSerializer::readText(buffer.data(), (size_t)file.gcount());
+        for (auto& note : fieldNotes) {
+            note.setTitle(EncodingUtils::cp1251_to_utf8(note.getTitle()));
+            note.setContent(EncodingUtils::cp1251_to_utf8(note.getContent()));
+        }
+    });
+
+    // Перекодировка кусками в буфере чтения, разбор уже готового UTF-8
+    vector<Note> streamNotes;
+    double streamMs = measureMs([&]() {
+        ifstream file(BENCHMARK_TEXT_FILE, ios::binary);
+        TranscodingStreamBuf transcoding(file.rdbuf(), TextEncoding::Cp1251, TextEncoding::Utf8);
+        string buffer(fileSize * 2, '\0');
+        size_t used = 0;
+        streamsize got;
+        while ((got = transcoding.sgetn(&buffer[used], (streamsize)(buffer.size() - used))) > 0) {
+            used += (size_t)got;
+            if (used == buffer.size()) buffer.resize(buffer.size() * 2);
+        }
+        streamNotes = NoteSerializer::readText(buffer.data(), used);
+    });
+    remove(BENCHMARK_TEXT_FILE);
+
+    cout << "Разбор и перекодировка строк: " << fieldMs << " мс" << endl;
+    cout << "Перекодировка при чтении: " << streamMs << " мс" << endl;
+
+    bool same = fieldNotes.size() == streamNotes.size();
+    for (size_t i = 0; same && i < streamNotes.size(); ++i) {
+        same = fieldNotes[i].getTitle() == streamNotes[i].getTitle() &&
+            fieldNotes[i].getContent() == streamNotes[i].getContent();
+    }
+    if (!same) {
+        cout << "! Результаты загрузки не совпадают" << endl;
+    }
+}
+
+void Benchmarks::runUtf8Folding(size_t noteCount) {
+    cout << "\n=== РЕГИСТР UTF-8 ===" << endl;
+
+    string cp1251Text;
+    for (size_t i = 0; i < noteCount; ++i) {
+        Note note = makeSyntheticNote(i);
+        cp1251Text += note.getTitle();
+        cp1251Text += note.getContent();
+    }
+    const string text = EncodingUtils::cp1251_to_utf8(cp1251Text);
+    const int repeats = 5;
+
+    // Без таблицы UTF-8: перекодировать в CP-1251, привести регистр по байтам и вернуть обратно
+    string roundTrip;
+    double roundTripMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) {
+            roundTrip = EncodingUtils::cp1251_to_utf8(
+                CaseFolding::toLowerCp1251(EncodingUtils::utf8_to_cp1251(text)));
+        }
+    });
+
+    string folded;
+    double tableMs = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) folded = CaseFolding::toLowerUtf8(text);
+    });
+
+    // Для сравнения - приведение регистра того же текста в CP-1251
+    string cp1251Folded;
+    double cp1251Ms = measureMs([&]() {
+        for (int r = 0; r < repeats; ++r) cp1251Folded = CaseFolding::toLowerCp1251(cp1251Text);
+    });
+
+    double megabytes = (double)text.size() * repeats / (1024.0 * 1024.0);
+    cout << "Текст: " << text.size() / (1024 * 1024) << " МБ UTF-8, " << repeats << " проходов" << endl;
+    cout << "Через CP-1251: " << roundTripMs << " мс (" << megabytes / roundTripMs * 1000.0 << " МБ/с)" << endl;
+    cout << "Таблица кодовых точек: " << tableMs << " мс (" << megabytes / tableMs * 1000.0 << " МБ/с)" << endl;
+    cout << "CP-1251 по байтам (тот же текст): " << cp1251Ms << " мс" << endl;
+    if (folded != roundTrip) {
+        cout << "! Результаты приведения регистра не совпадают" << endl;
+    }
+}
+
+void Benchmarks::runEncodingDetection(size_t noteCount) {
+    cout << "\n=== ОПРЕДЕЛЕНИЕ КОДИРОВКИ ===" << endl;
+
+    string cp1251Text;
+    for (size_t i = 0; i < noteCount; ++i) {
+        Note note = makeSyntheticNote(i);
+        cp1251Text += note.getTitle();
+        cp1251Text += note.getContent();
+    }
+    const string utf8Text = EncodingUtils::cp1251_to_utf8(cp1251Text);
+    const int repeats = 5;
+
+    // Последовательно: проверка UTF-8 без таблиц и подсчёт старших байтов по одному
+    auto detectScalar = [](const string& text) {
+        size_t high = 0, continuation = 0;
+        for (char c : text) {
+            unsigned char byte = (unsigned char)c;
+            if (byte >= 0x80) ++high;
+            if (byte >= 0x80 && byte < 0xC0) ++continuation;
+        }
+        if (high == 0) return TextEncoding::Cp1251;
+        if (EncodingUtils::is_valid_utf8_scalar(text.data(), text.size())) return TextEncoding::Utf8;
+        return TextEncoding::Cp1251;  // Некорректный UTF-8 - всегда CP-1251
+    };
+
+    const string* texts[] = { &cp1251Text, &utf8Text };
+    const char* names[] = { "CP-1251", "UTF-8" };
+    const TextEncoding expected[] = { TextEncoding::Cp1251, TextEncoding::Utf8 };
+    for (int t = 0; t < 2; ++t) {
+        const string& text = *texts[t];
+        TextEncoding scalarResult = TextEncoding::Cp1251, vectorResult = TextEncoding::Cp1251;
+        double scalarMs = measureMs([&]() {
+            for (int r = 0; r < repeats; ++r) scalarResult = detectScalar(text);
+        });
+        double vectorMs = measureMs([&]() {
+            for (int r = 0; r < repeats; ++r) {
+                vectorResult = EncodingUtils::detect_encoding(text.data(), text.size(), TextEncoding::Cp1251).encoding;
+            }
+        });
+
+        double megabytes = (double)text.size() * repeats / (1024.0 * 1024.0);
+        cout << names[t] << ", " << text.size() / (1024 * 1024) << " МБ: последовательно "
+            << scalarMs / megabytes << " мс/МБ, векторно " << vectorMs / megabytes << " мс/МБ" << endl;
+        if (scalarResult != expected[t] || vectorResult != expected[t]) {
+            cout << "! Кодировка определена неверно" << endl;
+        }
+    }
+
+    // Загрузка читает не весь файл, а три окна
+    cout << "Образец при загрузке: до " << 3 * EncodingUtils::DETECTION_WINDOW / 1024 << " КБ на файл" << endl;
+}
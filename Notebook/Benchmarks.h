@@ -0,0 +1,60 @@
+// Benchmarks.h
+#pragma once
+
+#include <cstddef>
+
+//  Benchmarks -      
+//        
+class Benchmarks {
+public:
+    //   :       
+    static void runTextLoad(size_t noteCount);
+
+    //  :  vector::erase    
+    static void runBulkRemove(size_t noteCount);
+
+    // :           
+    static void runSearchAllocations(size_t noteCount);
+
+    //   : vector<Note>      
+    static void runColumnScan(size_t noteCount);
+
+    //  " , ":     findByTags
+    static void runTagQuery(size_t noteCount);
+
+    //  :        
+    static void runTrigramSearch(size_t noteCount);
+
+    //  :      , SSE2  AVX2 
+    static void runFoldedSearch(size_t noteCount);
+
+    //   :        
+    static void runFoldedCache(size_t noteCount);
+
+    //    :     ,  
+    static void runParallelScan(size_t noteCount);
+
+    //   :     k   BM25   
+    static void runRankedSearch(size_t noteCount);
+
+    //    CP-1251 <-> UTF-8   ( Windows -   Win32)
+    static void runTranscode(size_t noteCount);
+
+    //  UTF-8:       
+    static void runUtf8Validation(size_t noteCount);
+
+    //    CP-1251  UTF-8:     
+    //    
+    static void runStreamingTranscode(size_t noteCount);
+
+    //   UTF-8:  CP-1251      
+    static void runUtf8Folding(size_t noteCount);
+
+    //    CP-1251  UTF-8:   
+    //     (  )
+    static void runEncodingDetection(size_t noteCount);
+
+private:
+    //      ,     
+    static size_t writeSyntheticTextFile(const char* path, size_t noteCount);
+};
@@ -0,0 +1,112 @@
+// BinaryIO.h
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+//   / (little-endian),     
+namespace BinaryIO {
+
+    // ==========  ==========
+
+    inline void putU8(std::ostream& out, uint8_t value) {
+        out.put((char)value);
+    }
+
+    inline void putU16(std::ostream& out, uint16_t value) {
+        char bytes[2] = { (char)(value & 0xFF), (char)(value >> 8) };
+        out.write(bytes, 2);
+    }
+
+    inline void putU32(std::ostream& out, uint32_t value) {
+        char bytes[4];
+        for (int i = 0; i < 4; ++i) bytes[i] = (char)((value >> (8 * i)) & 0xFF);
+        out.write(bytes, 4);
+    }
+
+    inline void putU64(std::ostream& out, uint64_t value) {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i) bytes[i] = (char)((value >> (8 * i)) & 0xFF);
+        out.write(bytes, 8);
+    }
+
+    inline void putString(std::ostream& out, const std::string& str) {
+        putU32(out, (uint32_t)str.size());
+        out.write(str.data(), (std::streamsize)str.size());
+    }
+
+    // ==========  ==========
+
+    //       
+    class Reader {
+    public:
+        Reader(const char* data, size_t size, size_t pos = 0) : data(data), size(size), pos(pos) {}
+
+        uint8_t u8() {
+            require(1);
+            return (uint8_t)data[pos++];
+        }
+
+        uint16_t u16() {
+            require(2);
+            const unsigned char* p = (const unsigned char*)data + pos;
+            pos += 2;
+            return (uint16_t)(p[0] | (p[1] << 8));
+        }
+
+        uint32_t u32() {
+            require(4);
+            const unsigned char* p = (const unsigned char*)data + pos;
+            pos += 4;
+            return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        }
+
+        uint64_t u64() {
+            uint64_t low = u32();
+            uint64_t high = u32();
+            return low | (high << 32);
+        }
+
+        std::string str() {
+            uint32_t length = u32();
+            require(length);
+            std::string result(data + pos, length);
+            pos += length;
+            return result;
+        }
+
+        //   :  ,    
+        std::string_view view() {
+            uint32_t length = u32();
+            require(length);
+            std::string_view result(data + pos, length);
+            pos += length;
+            return result;
+        }
+
+        void skip(size_t count) {
+            require(count);
+            pos += count;
+        }
+
+        size_t position() const { return pos; }
+        size_t remaining() const { return size - pos; }
+
+    private:
+        const char* data;
+        size_t size;
+        size_t pos;
+
+        void require(size_t count) const {
+            if (count > size - pos) {
+                throw std::runtime_error("Corrupted binary notes data: unexpected end of data");
+            }
+        }
+    };
+
+} // namespace BinaryIO
@@ -0,0 +1,142 @@
+﻿#include "CaseFolding.h"
+#include <cstdint>
+
+// Серии ASCII приводятся к нижнему регистру по 16 байт за шаг на x64, где SSE2 есть всегда
+#if defined(_M_X64) || defined(__x86_64__)
+#define CASE_FOLDING_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace CaseFolding {
+
+    namespace {
+
+        // ========== ТАБЛИЦА ==========
+
+        // Кодовые точки двухбайтовых последовательностей (U+0080-U+07FF) -> нижний регистр
+        // Строится один раз по правилам блоков; символ без пары отображается в себя
+        struct LowerTable {
+            uint16_t lower[0x800];
+
+            LowerTable() {
+                for (uint32_t cp = 0; cp < 0x800; ++cp) lower[cp] = (uint16_t)cp;
+
+                // Latin-1: À-Þ, кроме знака умножения
+                for (uint32_t cp = 0xC0; cp <= 0xDE; ++cp) {
+                    if (cp != 0xD7) lower[cp] = (uint16_t)(cp + 0x20);
+                }
+
+                // Latin Extended-A: пары "прописная, строчная"; İ не входит - её строчная однобайтовая
+                for (uint32_t cp = 0x100; cp <= 0x12F; cp += 2) lower[cp] = (uint16_t)(cp + 1);
+                for (uint32_t cp = 0x132; cp <= 0x137; cp += 2) lower[cp] = (uint16_t)(cp + 1);
+                for (uint32_t cp = 0x139; cp <= 0x148; cp += 2) lower[cp] = (uint16_t)(cp + 1);
+                for (uint32_t cp = 0x14A; cp <= 0x177; cp += 2) lower[cp] = (uint16_t)(cp + 1);
+                lower[0x178] = 0xFF;  // Ÿ
+                for (uint32_t cp = 0x179; cp <= 0x17E; cp += 2) lower[cp] = (uint16_t)(cp + 1);
+
+                // Кириллица: Ѐ-Џ, А-Я, затем пары в расширенных блоках
+                for (uint32_t cp = 0x400; cp <= 0x40F; ++cp) lower[cp] = (uint16_t)(cp + 0x50);
+                for (uint32_t cp = 0x410; cp <= 0x42F; ++cp) lower[cp] = (uint16_t)(cp + 0x20);
+                for (uint32_t cp = 0x460; cp <= 0x481; cp += 2) lower[cp] = (uint16_t)(cp + 1);
+                for (uint32_t cp = 0x48A; cp <= 0x4BF; cp += 2) lower[cp] = (uint16_t)(cp + 1);
+                lower[0x4C0] = 0x4CF;  // Палочка
+                for (uint32_t cp = 0x4C1; cp <= 0x4CE; cp += 2) lower[cp] = (uint16_t)(cp + 1);
+                for (uint32_t cp = 0x4D0; cp <= 0x52F; cp += 2) lower[cp] = (uint16_t)(cp + 1);
+            }
+        };
+
+        const LowerTable& lowerTable() {
+            static const LowerTable table;
+            return table;
+        }
+
+        inline bool isContinuation(unsigned char byte) {
+            return (byte & 0xC0) == 0x80;
+        }
+
+        // ========== СЕРИИ ASCII ==========
+
+        // Привести к нижнему регистру начальную серию ASCII, вернуть её длину
+        inline size_t foldAscii(char* data, size_t size) {
+            size_t i = 0;
+#ifdef CASE_FOLDING_SSE2
+            for (; i + 16 <= size; i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+                if (_mm_movemask_epi8(v) != 0) break;
+                // A-Z: после сдвига начала диапазона к -128 - знаковое сравнение
+                __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8((char)(-128 + 26)),
+                    _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - 'A'))));
+                _mm_storeu_si128((__m128i*)(data + i), _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+            }
+#endif
+            for (; i < size && (unsigned char)data[i] < 0x80; ++i) {
+                if (data[i] >= 'A' && data[i] <= 'Z') data[i] = (char)(data[i] - 'A' + 'a');
+            }
+            return i;
+        }
+
+    } // namespace
+
+    void foldUtf8(char* data, size_t size) {
+        const LowerTable& table = lowerTable();
+        size_t i = 0;
+
+        while (i < size) {
+            i += foldAscii(data + i, size - i);
+
+            // Серия не-ASCII символов; двухбайтовые - по таблице, прочие пропускаются целиком
+            while (i < size && (unsigned char)data[i] >= 0x80) {
+                unsigned char lead = (unsigned char)data[i];
+                if (lead >= 0xC2 && lead <= 0xDF && i + 1 < size && isContinuation((unsigned char)data[i + 1])) {
+                    uint32_t cp = ((uint32_t)(lead & 0x1F) << 6) | ((unsigned char)data[i + 1] & 0x3F);
+                    uint32_t lower = table.lower[cp];
+                    if (lower != cp) {
+                        data[i] = (char)(0xC0 | (lower >> 6));
+                        data[i + 1] = (char)(0x80 | (lower & 0x3F));
+                    }
+                    i += 2;
+                }
+                else {
+                    ++i;  // Байт трёх- и четырёхбайтовых символов или некорректный байт
+                }
+            }
+        }
+    }
+
+    std::string toLowerUtf8(std::string_view text) {
+        std::string result(text);
+        if (!result.empty()) foldUtf8(&result[0], result.size());
+        return result;
+    }
+
+    size_t utf8Char(std::string_view text, size_t pos, bool& wordChar) {
+        unsigned char lead = (unsigned char)text[pos];
+        if (lead < 0x80) {
+            wordChar = (lead >= 'a' && lead <= 'z') || (lead >= 'A' && lead <= 'Z') || (lead >= '0' && lead <= '9');
+            return 1;
+        }
+
+        size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC2 ? 2 : 0;
+        if (length == 0 || lead > 0xF4 || pos + length > text.size()) {
+            wordChar = false;
+            return 1;
+        }
+        uint32_t cp = lead & (0x7F >> length);
+        for (size_t k = 1; k < length; ++k) {
+            unsigned char next = (unsigned char)text[pos + k];
+            if (!isContinuation(next)) {
+                wordChar = false;
+                return 1;
+            }
+            cp = (cp << 6) | (next & 0x3F);
+        }
+
+        // Буквы - от Latin-1 (кроме знаков умножения и деления); знаки препинания, стрелки,
+        // математические символы, псевдографика и эмодзи разделяют слова
+        wordChar = cp >= 0xC0 && cp != 0xD7 && cp != 0xF7 &&
+            !(cp >= 0x2000 && cp <= 0x2BFF) && !(cp >= 0x3000 && cp <= 0x303F) &&
+            !(cp >= 0x1F000 && cp <= 0x1FAFF);
+        return length;
+    }
+
+} // namespace CaseFolding
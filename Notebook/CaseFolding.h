@@ -0,0 +1,81 @@
+// CaseFolding.h
+#pragma once
+
+#include "EncodingUtils.h"
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+//        
+//   CP-1251   ;  UTF-8 -     
+// (CaseFolding.cpp).     (Notebook::setTextEncoding).
+namespace CaseFolding {
+
+    //   CP-1251    (   )
+    inline char foldCp1251(char c) {
+        if (c >= -64 && c <= -33) {  // -
+            return (char)(c + 32);
+        }
+        if (c == -88) {  // 
+            return -72;  // 
+        }
+        if (c >= 'A' && c <= 'Z') {
+            return (char)(c - 'A' + 'a');
+        }
+        return c;
+    }
+
+    //  CP-1251   : ,   
+    inline bool isWordCharCp1251(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+            (c >= -64 && c <= -1) ||  // -
+            c == -88 || c == -72;     // , 
+    }
+
+    //  CP-1251   
+    inline std::string toLowerCp1251(const std::string& str) {
+        std::string result = str;
+        for (char& c : result) {
+            c = foldCp1251(c);
+        }
+        return result;
+    }
+
+    //       (    )
+    //    ,     
+    inline bool containsFoldedCp1251(std::string_view text, std::string_view foldedPattern) {
+        if (foldedPattern.empty()) return true;
+        if (foldedPattern.size() > text.size()) return false;
+
+        const char first = foldedPattern[0];
+        const size_t last = text.size() - foldedPattern.size();
+        for (size_t i = 0; i <= last; ++i) {
+            if (foldCp1251(text[i]) != first) continue;
+            size_t j = 1;
+            while (j < foldedPattern.size() && foldCp1251(text[i + j]) == foldedPattern[j]) ++j;
+            if (j == foldedPattern.size()) return true;
+        }
+        return false;
+    }
+
+    // ========== UTF-8 ==========
+
+    //   UTF-8     :  (ASCII, Latin-1, Latin Extended-A)
+    //   (U+0400-U+052F).        ,
+    //     ;       
+    void foldUtf8(char* data, size_t size);
+
+    //  UTF-8   
+    std::string toLowerUtf8(std::string_view text);
+
+    //   UTF-8,   text[pos] (1   );
+    // wordChar -    :   ,    ,   
+    size_t utf8Char(std::string_view text, size_t pos, bool& wordChar);
+
+    // ==========    ==========
+
+    inline std::string toLower(std::string_view text, TextEncoding encoding) {
+        return encoding == TextEncoding::Utf8 ? toLowerUtf8(text) : toLowerCp1251(std::string(text));
+    }
+
+} // namespace CaseFolding
@@ -1,4 +1,5 @@
 #include "ConsoleUI.h"
+#include "Benchmarks.h"
 #include <iostream>
 #include <limits>
 #include <algorithm>
@@ -13,6 +14,40 @@
 
 using namespace std;
 
+namespace {
+
+    //    :    
+    struct BenchmarkItem {
+        const char* title;
+        void (*run)(size_t noteCount);
+    };
+
+    const BenchmarkItem BENCHMARKS[] = {
+        { "  ", &Benchmarks::runTextLoad },
+        { " ", &Benchmarks::runBulkRemove },
+        { "   ", &Benchmarks::runSearchAllocations },
+        { "    ", &Benchmarks::runColumnScan },
+        { "   ", &Benchmarks::runTagQuery },
+        { "   ", &Benchmarks::runTrigramSearch },
+        { " ", &Benchmarks::runFoldedSearch },
+        { "    ", &Benchmarks::runFoldedCache },
+        { " ", &Benchmarks::runParallelScan },
+        { "   BM25", &Benchmarks::runRankedSearch },
+        { " CP-1251 <-> UTF-8", &Benchmarks::runTranscode },
+        { " UTF-8", &Benchmarks::runUtf8Validation },
+        { "  ", &Benchmarks::runStreamingTranscode },
+        { "  UTF-8", &Benchmarks::runUtf8Folding },
+        { " ", &Benchmarks::runEncodingDetection }
+    };
+
+    const int BENCHMARK_COUNT = (int)(sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]));
+
+    //           
+    const int BENCHMARK_DEFAULT_NOTES = 100000;
+    const int BENCHMARK_MAX_NOTES = 1000000;
+
+} // namespace
+
 //    
 void ConsoleUI::run() {
     clearScreen();  //  
@@ -52,10 +87,11 @@ void ConsoleUI::showMainMenu() {
     cout << "7.   " << endl;
     cout << "8.   " << endl;
     cout << "9.  " << endl;
+    cout << "10.  " << endl;
     cout << "0. " << endl;
     cout << "=================" << endl;
 
-    int choice = getChoice(0, 9);
+    int choice = getChoice(0, 10);
 
     switch (choice) {
     case 1: handleCreateNote(); break;
@@ -67,6 +103,7 @@ void ConsoleUI::showMainMenu() {
     case 7: handleSave(); break;
     case 8: handleLoad(); break;
     case 9: handleTestScenarios(); break;
+    case 10: handleBenchmarks(); break;
     case 0:
         if (unsavedChanges) {
             cout << "  .   ? ( - 1): ";
@@ -124,7 +161,7 @@ void ConsoleUI::handleViewNote() {
 
     int index = noteNumber - 1;
 
-    Note* note = notebook.getNote(index);
+    const Note* note = notebook.getNote(index);
     if (note) {
         note->print();
 
@@ -134,29 +171,26 @@ void ConsoleUI::handleViewNote() {
 
         int choice = getChoice(0, 1);
         if (choice == 1) {
-            handleEditNote(index);
+            handleEditNote(note->getId());
         }
     }
 }
 
 //  
-void ConsoleUI::handleEditNote(int index) {
-    if (index < 0 || index >= notebook.getNoteCount()) {
-        cout << "  ." << endl;
-        pressAnyKey();
-        return;
-    }
-
-    Note* note = notebook.getNote(index);
-    if (!note) {
+void ConsoleUI::handleEditNote(NoteId id) {
+    const Note* original = notebook.getNoteById(id);
+    if (!original) {
         cout << "  ." << endl;
         pressAnyKey();
         return;
     }
 
+    //       notebook,     
+    Note edited = *original;
+
     clearScreen();
     cout << "===   ===" << endl;
-    note->print();
+    edited.print();
 
     cout << "\n   ?" << endl;
     cout << "1. " << endl;
@@ -171,21 +205,22 @@ void ConsoleUI::handleEditNote(int index) {
     try {
         switch (choice) {
         case 1:
-            note->setTitle(getString(" : "));
+            edited.setTitle(getString(" : "));
             break;
         case 2:
-            note->setContent(getString(" : "));
+            edited.setContent(getString(" : "));
             break;
         case 3:
-            note->setTags(getTags());
+            edited.setTags(getTags());
             break;
         case 4:
-            note->setTitle(getString(" : "));
-            note->setContent(getString(" : "));
-            note->setTags(getTags());
+            edited.setTitle(getString(" : "));
+            edited.setContent(getString(" : "));
+            edited.setTags(getTags());
             break;
         }
 
+        notebook.updateNoteById(id, edited);
         unsavedChanges = true;
         cout << "\n  !" << endl;
     }
@@ -211,8 +246,8 @@ void ConsoleUI::handleDeleteNote() {
 
     if (index == 0) return;  // 0 - 
 
-    //    
-    int actualIndex = index - 1;
+    //    
+    NoteId id = notebook.getNote(index - 1)->getId();
 
     cout << " ? ( - 1): ";
     char confirm;
@@ -220,7 +255,7 @@ void ConsoleUI::handleDeleteNote() {
     cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
     if (confirm == '1') {
-        if (notebook.removeNote(actualIndex)) {
+        if (notebook.removeNoteById(id)) {
             unsavedChanges = true;
             cout << " ." << endl;
         }
@@ -240,6 +275,10 @@ void ConsoleUI::showSearchMenu() {
     cout << "3.  " << endl;
     cout << "4.  " << endl;
     cout << "5.   N " << endl;
+    cout << "6.   " << endl;
+    cout << "7.   ( )" << endl;
+    cout << "8.    ( /  /  )" << endl;
+    cout << "9.    " << endl;
     cout << "0. " << endl;
 }
 
@@ -248,7 +287,7 @@ void ConsoleUI::handleSearch() {
     clearScreen();
     showSearchMenu();
 
-    int choice = getChoice(0, 5);
+    int choice = getChoice(0, 9);
     if (choice == 0) return;
 
     vector<int> results;
@@ -269,6 +308,24 @@ void ConsoleUI::handleSearch() {
     case 5:
         results = notebook.findByLastNDays(getInt("  : ", 1, 365));
         break;
+    case 6:
+        results = notebook.findByWord(getString("   : "), WordMatch::WholeWord);
+        break;
+    case 7:
+        results = notebook.findByTag(getString(" : "), TagMatch::Exact);
+        break;
+    case 8: {
+        vector<string> all = getTags("  ( ,  ): ");
+        vector<string> any = getTags("     ( ,  ): ");
+        vector<string> none = getTags("    ( ,  ): ");
+        results = notebook.findByTags(all, any, none);
+        break;
+    }
+    case 9: {
+        string query = getString("   : ");
+        results = notebook.findTopByWord(query, (size_t)getInt("  : ", 1, 100));
+        break;
+    }
     }
 
     notebook.printNotes(results);
@@ -280,7 +337,7 @@ void ConsoleUI::handleStatistics() {
     clearScreen();
     cout << "===  ===" << endl;
 
-    auto authorStats = notebook.getAuthorStats();
+    const auto& authorStats = notebook.getAuthorStats();
     cout << "\n :" << endl;
     if (authorStats.empty()) {
         cout << " " << endl;
@@ -291,7 +348,7 @@ void ConsoleUI::handleStatistics() {
         }
     }
 
-    auto tagStats = notebook.getTagStats();
+    const auto& tagStats = notebook.getTagStats();
     cout << "\n :" << endl;
     if (tagStats.empty()) {
         cout << " " << endl;
@@ -338,6 +395,40 @@ void ConsoleUI::handleTestScenarios() {
     pressAnyKey();
 }
 
+//   
+void ConsoleUI::showBenchmarksMenu() {
+    cout << "===   ===" << endl;
+    for (int i = 0; i < BENCHMARK_COUNT; ++i) {
+        cout << i + 1 << ". " << BENCHMARKS[i].title << endl;
+    }
+    cout << BENCHMARK_COUNT + 1 << ".   " << endl;
+    cout << "0. " << endl;
+}
+
+//  
+void ConsoleUI::handleBenchmarks() {
+    clearScreen();
+    showBenchmarksMenu();
+
+    int choice = getChoice(0, BENCHMARK_COUNT + 1);
+    if (choice == 0) return;
+
+    int noteCount = getInt("   (1000 - " + to_string(BENCHMARK_MAX_NOTES) +
+        ", Enter - " + to_string(BENCHMARK_DEFAULT_NOTES) + "): ", 1000, BENCHMARK_MAX_NOTES, BENCHMARK_DEFAULT_NOTES);
+
+    try {
+        for (int i = 0; i < BENCHMARK_COUNT; ++i) {
+            if (choice == i + 1 || choice == BENCHMARK_COUNT + 1) {
+                BENCHMARKS[i].run((size_t)noteCount);
+            }
+        }
+    }
+    catch (const exception& e) {
+        cout << ": " << e.what() << endl;
+    }
+    pressAnyKey();
+}
+
 
 //  
 int ConsoleUI::getChoice(int min, int max) {
@@ -397,9 +488,36 @@ int ConsoleUI::getInt(const string& prompt, int min, int max) {
     return value;
 }
 
+int ConsoleUI::getInt(const string& prompt, int min, int max, int defaultValue) {
+    while (true) {
+        string input = getString(prompt, true);
+        if (input.empty()) return defaultValue;
+
+        size_t used = 0;
+        int value = 0;
+        try {
+            value = stoi(input, &used);
+        }
+        catch (const exception&) {
+            used = 0;
+        }
+
+        if (used != input.size() || value < min || value > max) {
+            cout << " .  : " << min << " - " << max << endl;
+        }
+        else {
+            return value;
+        }
+    }
+}
+
 vector<string> ConsoleUI::getTags() {
+    return getTags("  ( ): ");
+}
+
+vector<string> ConsoleUI::getTags(const string& prompt) {
     vector<string> tags;
-    cout << "  ( ): ";
+    cout << prompt;
     string input;
     getline(cin, input);
 
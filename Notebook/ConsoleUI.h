@@ -19,6 +19,9 @@ private:
     //   
     void showSearchMenu();
 
+    //    
+    void showBenchmarksMenu();
+
     // ==========   ==========
 
     //    
@@ -30,8 +33,8 @@ private:
     //    
     void handleViewNote();
 
-    //   
-    void handleEditNote(int index);
+    //    ( )
+    void handleEditNote(NoteId id);
 
     //   
     void handleDeleteNote();
@@ -51,6 +54,9 @@ private:
     //    
     void handleTestScenarios();
 
+    //    
+    void handleBenchmarks();
+
     ////   
     //void handlePolymorphismDemo();
 
@@ -65,8 +71,12 @@ private:
     //        
     int getInt(const std::string& prompt, int min, int max);
 
+    //  ,   (Enter)  defaultValue
+    int getInt(const std::string& prompt, int min, int max, int defaultValue);
+
     //      ( )
     std::vector<std::string> getTags();
+    std::vector<std::string> getTags(const std::string& prompt);
 
     //    Enter  
     void pressAnyKey();
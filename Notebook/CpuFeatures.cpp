@@ -0,0 +1,41 @@
+﻿#include "CpuFeatures.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CPU_FEATURES_X64 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+namespace CpuFeatures {
+
+    namespace {
+
+        bool detectAvx2() {
+#if defined(CPU_FEATURES_X64) && defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#elif defined(CPU_FEATURES_X64)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        }
+
+    } // namespace
+
+    bool hasAvx2() {
+        static const bool avx2 = detectAvx2();
+        return avx2;
+    }
+
+} // namespace CpuFeatures
@@ -0,0 +1,12 @@
+// CpuFeatures.h
+#pragma once
+
+//   ,        
+//       
+namespace CpuFeatures {
+
+    // AVX2   ,    (  YMM)
+    //  x64  false
+    bool hasAvx2();
+
+} // namespace CpuFeatures
@@ -1,60 +1,519 @@
-#include "EncodingUtils.h"
+﻿#include "EncodingUtils.h"
+#include "CpuFeatures.h"
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
 
-std::string EncodingUtils::cp1251_to_utf8(const std::string& cp1251) {
-    if (cp1251.empty()) return "";
+// Серии ASCII копируются векторно только на x64, где SSE2 есть всегда;
+// проверка UTF-8 по таблицам использует AVX2, если он есть
+#if defined(_M_X64) || defined(__x86_64__)
+#define ENCODING_UTILS_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ENCODING_UTILS_AVX2
+#else
+#define ENCODING_UTILS_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+    // ========== ТАБЛИЦЫ ==========
+
+    // Кодовые точки Unicode для байтов 0x80-0xFF; 0x98 в CP-1251 не занят и сохраняется как U+0098
+    const uint16_t CP1251_HIGH[128] = {
+            0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021,  // 80
+            0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,  // 88
+            0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,  // 90
+            0x0098, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,  // 98
+            0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7,  // A0
+            0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,  // A8
+            0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7,  // B0
+            0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457,  // B8
+            0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,  // C0
+            0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,  // C8
+            0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,  // D0
+            0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,  // D8
+            0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,  // E0
+            0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,  // E8
+            0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,  // F0
+            0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F,  // F8
+    };
+
+    // Байты UTF-8 символа верхней половины CP-1251 (два или три)
+    struct Utf8Sequence {
+        unsigned char length;
+        char bytes[3];
+    };
+
+    // Прямая таблица и обратные страницы: младший байт кодовой точки -> байт CP-1251 (0 - символа нет)
+    // Символы верхней половины CP-1251 лежат на страницах U+00xx, U+04xx, U+20xx и U+21xx
+    struct Tables {
+        Utf8Sequence toUtf8[128];
+        unsigned char pages[4][256];
 
-    // CP-1251 -> UTF-16
-    int wsize = MultiByteToWideChar(1251, 0, cp1251.c_str(), -1, NULL, 0);
-    if (wsize <= 0) return cp1251;
+        Tables() {
+            std::memset(pages, 0, sizeof(pages));
+            for (int i = 0; i < 128; ++i) {
+                uint32_t codePoint = CP1251_HIGH[i];
+                Utf8Sequence& sequence = toUtf8[i];
+                if (codePoint < 0x800) {
+                    sequence.length = 2;
+                    sequence.bytes[0] = (char)(0xC0 | (codePoint >> 6));
+                    sequence.bytes[1] = (char)(0x80 | (codePoint & 0x3F));
+                    sequence.bytes[2] = 0;
+                }
+                else {
+                    sequence.length = 3;
+                    sequence.bytes[0] = (char)(0xE0 | (codePoint >> 12));
+                    sequence.bytes[1] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                    sequence.bytes[2] = (char)(0x80 | (codePoint & 0x3F));
+                }
+                pages[pageOf(codePoint)][codePoint & 0xFF] = (unsigned char)(0x80 + i);
+            }
+        }
 
-    wchar_t* wbuf = new wchar_t[wsize];
-    MultiByteToWideChar(1251, 0, cp1251.c_str(), -1, wbuf, wsize);
+        static int pageOf(uint32_t codePoint) {
+            switch (codePoint >> 8) {
+            case 0x00: return 0;
+            case 0x04: return 1;
+            case 0x20: return 2;
+            case 0x21: return 3;
+            default: return -1;
+            }
+        }
+    };
 
-    // UTF-16 -> UTF-8
-    int size = WideCharToMultiByte(CP_UTF8, 0, wbuf, -1, NULL, 0, NULL, NULL);
-    if (size <= 0) {
-        delete[] wbuf;
-        return cp1251;
+    const Tables& tables() {
+        static const Tables instance;
+        return instance;
     }
 
-    char* buf = new char[size];
-    WideCharToMultiByte(CP_UTF8, 0, wbuf, -1, buf, size, NULL, NULL);
+    // ========== СЕРИИ ASCII ==========
 
-    std::string result(buf);
-    delete[] wbuf;
-    delete[] buf;
+#ifdef ENCODING_UTILS_SSE2
+    inline unsigned lowestBit(unsigned mask) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (unsigned)index;
+#else
+        return (unsigned)__builtin_ctz(mask);
+#endif
+    }
+#endif
 
-    return result;
+    // Скопировать начальную серию ASCII из src в dst, вернуть её длину
+    // Блок пишется целиком, поэтому в dst может попасть до 15 байт за серией: вызывающие
+    // гарантируют, что выход не длиннее входа на этом участке, и перезаписывают их
+    inline size_t copyAscii(const char* src, size_t size, char* dst) {
+        size_t i = 0;
+#ifdef ENCODING_UTILS_SSE2
+        for (; i + 16 <= size; i += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_si128((__m128i*)(dst + i), chunk);
+            unsigned mask = (unsigned)_mm_movemask_epi8(chunk);
+            if (mask != 0) return i + lowestBit(mask);
+        }
+#else
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, src + i, 8);
+            if (word & 0x8080808080808080ULL) break;
+            std::memcpy(dst + i, &word, 8);
+        }
+#endif
+        while (i < size && (unsigned char)src[i] < 0x80) {
+            dst[i] = src[i];
+            ++i;
+        }
+        return i;
+    }
+
+    // ========== РАЗБОР UTF-8 ==========
+
+    // Длина корректной многобайтовой последовательности в начале src (2-4) или 0
+    // Отвергаются обрывы, лишние продолжения, избыточные формы, суррогаты и точки выше U+10FFFF
+    inline size_t decodeUtf8(const char* src, size_t available, uint32_t& codePoint) {
+        unsigned char lead = (unsigned char)src[0];
+        size_t length;
+        uint32_t minimum;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+            minimum = 0x80;
+            codePoint = lead & 0x1F;
+        }
+        else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            minimum = 0x800;
+            codePoint = lead & 0x0F;
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            minimum = 0x10000;
+            codePoint = lead & 0x07;
+        }
+        else {
+            return 0;
+        }
+        if (length > available) {
+            return 0;
+        }
+
+        for (size_t k = 1; k < length; ++k) {
+            unsigned char next = (unsigned char)src[k];
+            if ((next & 0xC0) != 0x80) return 0;
+            codePoint = (codePoint << 6) | (next & 0x3F);
+        }
+        if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+            return 0;
+        }
+        return length;
+    }
+
+    // Длина начальной серии ASCII
+    inline size_t asciiPrefix(const char* src, size_t size) {
+        size_t i = 0;
+#ifdef ENCODING_UTILS_SSE2
+        for (; i + 16 <= size; i += 16) {
+            unsigned mask = (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(src + i)));
+            if (mask != 0) return i + lowestBit(mask);
+        }
+#endif
+        while (i < size && (unsigned char)src[i] < 0x80) ++i;
+        return i;
+    }
+
+    // ========== ПРОВЕРКА UTF-8 ==========
+
+    bool validateScalar(const char* data, size_t size) {
+        size_t i = 0;
+        while (i < size) {
+            i += asciiPrefix(data + i, size - i);
+            if (i == size) break;
+
+            uint32_t codePoint = 0;
+            size_t length = decodeUtf8(data + i, size - i, codePoint);
+            if (length == 0) return false;
+            i += length;
+        }
+        return true;
+    }
+
+#ifdef ENCODING_UTILS_SSE2
+
+    // Проверка по таблицам (алгоритм Кайзера - Лемира): каждая ошибка UTF-8 видна по паре
+    // соседних байт. Старшая и младшая тетрады предыдущего байта и старшая тетрада текущего
+    // через pshufb дают по маске классов ошибок; их пересечение непусто только на ошибке.
+    // Продолжения третьего и четвёртого байта проверяются отдельно по байтам двумя и тремя раньше.
+    const uint8_t TOO_SHORT = 1 << 0;   // 11______ 0_______ или 11______ 11______
+    const uint8_t TOO_LONG = 1 << 1;    // 0_______ 10______
+    const uint8_t OVERLONG_3 = 1 << 2;  // 11100000 100_____
+    const uint8_t TOO_LARGE = 1 << 3;   // 11110100 1001____ и выше
+    const uint8_t SURROGATE = 1 << 4;   // 11101101 101_____
+    const uint8_t OVERLONG_2 = 1 << 5;  // 1100000_ 10______
+    const uint8_t TOO_LARGE_1000 = 1 << 6;  // 11110101 1000____ и выше
+    const uint8_t OVERLONG_4 = 1 << 6;  // 11110000 1000____
+    const uint8_t TWO_CONTS = 1 << 7;   // 10______ 10______
+    const uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+    // Таблица из 16 байт, повторённая в обеих половинах регистра (pshufb работает по 128 бит)
+    ENCODING_UTILS_AVX2 inline __m256i table16(uint8_t v0, uint8_t v1, uint8_t v2, uint8_t v3,
+        uint8_t v4, uint8_t v5, uint8_t v6, uint8_t v7, uint8_t v8, uint8_t v9, uint8_t v10,
+        uint8_t v11, uint8_t v12, uint8_t v13, uint8_t v14, uint8_t v15) {
+        return _mm256_setr_epi8((char)v0, (char)v1, (char)v2, (char)v3, (char)v4, (char)v5, (char)v6,
+            (char)v7, (char)v8, (char)v9, (char)v10, (char)v11, (char)v12, (char)v13, (char)v14, (char)v15,
+            (char)v0, (char)v1, (char)v2, (char)v3, (char)v4, (char)v5, (char)v6,
+            (char)v7, (char)v8, (char)v9, (char)v10, (char)v11, (char)v12, (char)v13, (char)v14, (char)v15);
+    }
+
+    ENCODING_UTILS_AVX2 inline __m256i highNibbles(__m256i v) {
+        return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+    }
+
+    // Байты блока, сдвинутые на N позиций назад с подстановкой хвоста предыдущего блока
+    template <int N>
+    ENCODING_UTILS_AVX2 inline __m256i previous(__m256i input, __m256i previousInput) {
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previousInput, input, 0x21), 16 - N);
+    }
+
+    // Состояние проверки между блоками: накопленные ошибки, предыдущий блок и признак обрыва в нём
+    // Функции, а не класс с полями-векторами: конструктор не получил бы атрибут AVX2 в GCC
+    ENCODING_UTILS_AVX2 inline void checkBlock(__m256i input, __m256i& error, __m256i& previousInput,
+        __m256i& previousIncomplete) {
+        if (_mm256_movemask_epi8(input) == 0) {
+            // Блок ASCII: ошибка только если предыдущий оборвался на середине символа
+            error = _mm256_or_si256(error, previousIncomplete);
+            previousInput = input;
+            return;
+        }
+
+        const __m256i prev1 = previous<1>(input, previousInput);
+        const __m256i byte1High = _mm256_shuffle_epi8(table16(
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            TOO_SHORT | OVERLONG_2,
+            TOO_SHORT,
+            TOO_SHORT | OVERLONG_3 | SURROGATE,
+            TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4), highNibbles(prev1));
+        const __m256i byte1Low = _mm256_shuffle_epi8(table16(
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+            CARRY | OVERLONG_2,
+            CARRY,
+            CARRY,
+            CARRY | TOO_LARGE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000), _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+        const __m256i byte2High = _mm256_shuffle_epi8(table16(
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT), highNibbles(input));
+        const __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+        // Третий и четвёртый байты обязаны быть продолжениями: такие позиции дают 0x80,
+        // что компенсирует TWO_CONTS из таблиц; лишнее или недостающее продолжение остаётся
+        const __m256i prev2 = previous<2>(input, previousInput);
+        const __m256i prev3 = previous<3>(input, previousInput);
+        const __m256i isThird = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+        const __m256i isFourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+        const __m256i mustContinue = _mm256_and_si256(_mm256_or_si256(isThird, isFourth), _mm256_set1_epi8((char)0x80));
+        error = _mm256_or_si256(error, _mm256_xor_si256(mustContinue, special));
+
+        // Блок оборвался на ведущем байте, если он стоит слишком близко к концу
+        previousIncomplete = _mm256_subs_epu8(input, _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1)));
+        previousInput = input;
+    }
+
+    ENCODING_UTILS_AVX2 bool validateAvx2(const char* data, size_t size) {
+        __m256i error = _mm256_setzero_si256();
+        __m256i previousInput = _mm256_setzero_si256();
+        __m256i previousIncomplete = _mm256_setzero_si256();
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            checkBlock(_mm256_loadu_si256((const __m256i*)(data + i)), error, previousInput, previousIncomplete);
+        }
+        if (i < size) {
+            // Хвост дополняется нулями - это ASCII, он не порождает ошибок
+            alignas(32) char tail[32] = {};
+            std::memcpy(tail, data + i, size - i);
+            checkBlock(_mm256_load_si256((const __m256i*)tail), error, previousInput, previousIncomplete);
+        }
+        error = _mm256_or_si256(error, previousIncomplete);
+        return _mm256_testz_si256(error, error) != 0;
+    }
+
+#endif // ENCODING_UTILS_SSE2
+
+    // ========== ГИСТОГРАММА БАЙТОВ ==========
+
+    // Число старших байтов по классам, которые различают UTF-8 и CP-1251
+    struct ByteClasses {
+        size_t high = 0;          // 0x80-0xFF
+        size_t continuation = 0;  // 0x80-0xBF: продолжения UTF-8, в CP-1251 - в основном знаки
+        size_t yo = 0;            // Ё и ё CP-1251 (0xA8, 0xB8) - буквы среди продолжений
+    };
+
+    inline void countByte(unsigned char byte, ByteClasses& classes) {
+        if (byte < 0x80) return;
+        ++classes.high;
+        if (byte < 0xC0) ++classes.continuation;
+        if (byte == 0xA8 || byte == 0xB8) ++classes.yo;
+    }
+
+#ifdef ENCODING_UTILS_SSE2
+    // Сумма 16 байтовых счётчиков
+    inline size_t sumBytes(__m128i counters) {
+        __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+        return (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+#endif
+
+    // Классы считаются по 16 байт за шаг: маски сравнений (-1) вычитаются из байтовых
+    // счётчиков, которые сбрасываются в суммы раньше, чем переполнятся
+    void countClasses(const char* data, size_t size, ByteClasses& classes) {
+        size_t i = 0;
+#ifdef ENCODING_UTILS_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i continuationEnd = _mm_set1_epi8((char)0xC0);
+        const __m128i upperYo = _mm_set1_epi8((char)0xA8);
+        const __m128i lowerYo = _mm_set1_epi8((char)0xB8);
+        while (i + 16 <= size) {
+            size_t blocks = (std::min)((size - i) / 16, (size_t)255);
+            __m128i high = zero, continuation = zero, yo = zero;
+            for (size_t b = 0; b < blocks; ++b, i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+                // Знаковое сравнение: старшие байты отрицательны, 0x80-0xBF меньше (char)0xC0
+                high = _mm_sub_epi8(high, _mm_cmplt_epi8(v, zero));
+                continuation = _mm_sub_epi8(continuation, _mm_cmplt_epi8(v, continuationEnd));
+                yo = _mm_sub_epi8(yo, _mm_or_si128(_mm_cmpeq_epi8(v, upperYo), _mm_cmpeq_epi8(v, lowerYo)));
+            }
+            classes.high += sumBytes(high);
+            classes.continuation += sumBytes(continuation);
+            classes.yo += sumBytes(yo);
+        }
+#endif
+        for (; i < size; ++i) {
+            countByte((unsigned char)data[i], classes);
+        }
+    }
+
+} // namespace
+
+// ========== ПЕРЕКОДИРОВКА ==========
+
+size_t EncodingUtils::cp1251_to_utf8(const char* src, size_t size, char* dst) {
+    const Tables& t = tables();
+    size_t in = 0, out = 0;
+
+    while (in < size) {
+        size_t run = copyAscii(src + in, size - in, dst + out);
+        in += run;
+        out += run;
+
+        // Серия символов верхней половины (кириллица, типографские знаки) - по таблице
+        while (in < size && (unsigned char)src[in] >= 0x80) {
+            const Utf8Sequence& sequence = t.toUtf8[(unsigned char)src[in] - 0x80];
+            dst[out] = sequence.bytes[0];
+            dst[out + 1] = sequence.bytes[1];
+            if (sequence.length == 3) dst[out + 2] = sequence.bytes[2];
+            out += sequence.length;
+            ++in;
+        }
+    }
+    return out;
 }
 
-std::string EncodingUtils::utf8_to_cp1251(const std::string& utf8) {
-    if (utf8.empty()) return "";
+size_t EncodingUtils::utf8_to_cp1251(const char* src, size_t size, char* dst) {
+    const Tables& t = tables();
+    size_t in = 0, out = 0;
 
-    // UTF-8 -> UTF-16
-    int wsize = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, NULL, 0);
-    if (wsize <= 0) return utf8;
+    while (in < size) {
+        size_t run = copyAscii(src + in, size - in, dst + out);
+        in += run;
+        out += run;
 
-    wchar_t* wbuf = new wchar_t[wsize];
-    MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, wbuf, wsize);
+        while (in < size && (unsigned char)src[in] >= 0x80) {
+            uint32_t codePoint = 0;
+            size_t length = decodeUtf8(src + in, size - in, codePoint);
+            if (length == 0) {
+                // Некорректный байт заменяется, разбор продолжается со следующего
+                dst[out++] = '?';
+                ++in;
+                continue;
+            }
+            in += length;
 
-    // UTF-16 -> CP-1251
-    int size = WideCharToMultiByte(1251, 0, wbuf, -1, NULL, 0, NULL, NULL);
-    if (size <= 0) {
-        delete[] wbuf;
-        return utf8;
+            int page = Tables::pageOf(codePoint);
+            unsigned char byte = page < 0 ? 0 : t.pages[page][codePoint & 0xFF];
+            dst[out++] = byte != 0 ? (char)byte : '?';
+        }
     }
+    return out;
+}
 
-    char* buf = new char[size];
-    WideCharToMultiByte(1251, 0, wbuf, -1, buf, size, NULL, NULL);
+size_t EncodingUtils::transcode(TextEncoding from, TextEncoding to, const char* src, size_t size, char* dst) {
+    if (from == to) {
+        if (size != 0) std::memcpy(dst, src, size);
+        return size;
+    }
+    return from == TextEncoding::Cp1251 ? cp1251_to_utf8(src, size, dst) : utf8_to_cp1251(src, size, dst);
+}
+
+size_t EncodingUtils::max_transcoded_size(TextEncoding from, TextEncoding to, size_t size) {
+    return from == TextEncoding::Cp1251 && to == TextEncoding::Utf8 ? size * MAX_UTF8_PER_CP1251 : size;
+}
+
+size_t EncodingUtils::utf8_complete_prefix(const char* data, size_t size) {
+    // Ищем ведущий байт среди последних трёх: символ оборван, если ему не хватает продолжений
+    for (size_t back = 1; back <= 3 && back <= size; ++back) {
+        unsigned char byte = (unsigned char)data[size - back];
+        if ((byte & 0xC0) == 0x80) continue;  // Продолжение - смотрим дальше назад
 
-    std::string result(buf);
-    delete[] wbuf;
-    delete[] buf;
+        size_t length = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 1;
+        return length > back ? size - back : size;
+    }
+    return size;
+}
 
+size_t EncodingUtils::utf8_sequence_start(const char* data, size_t size) {
+    size_t start = 0;
+    while (start < 3 && start < size && ((unsigned char)data[start] & 0xC0) == 0x80) ++start;
+    return start;
+}
+
+std::string EncodingUtils::cp1251_to_utf8(const std::string& cp1251) {
+    std::string result(cp1251.size() * MAX_UTF8_PER_CP1251, '\0');
+    result.resize(cp1251_to_utf8(cp1251.data(), cp1251.size(), &result[0]));
     return result;
 }
 
+std::string EncodingUtils::utf8_to_cp1251(const std::string& utf8) {
+    std::string result(utf8.size(), '\0');
+    result.resize(utf8_to_cp1251(utf8.data(), utf8.size(), &result[0]));
+    return result;
+}
+
+// ========== ПРОВЕРКА ==========
+
 bool EncodingUtils::is_valid_utf8(const std::string& str) {
-    int size = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str.c_str(), -1, NULL, 0);
-    return size > 0;
-}
\ No newline at end of file
+    return is_valid_utf8(str.data(), str.size());
+}
+
+bool EncodingUtils::is_valid_utf8(const char* data, size_t size) {
+#ifdef ENCODING_UTILS_SSE2
+    if (CpuFeatures::hasAvx2()) {
+        return validateAvx2(data, size);
+    }
+#endif
+    return validateScalar(data, size);
+}
+
+bool EncodingUtils::is_valid_utf8_scalar(const char* data, size_t size) {
+    return validateScalar(data, size);
+}
+
+// ========== ОПРЕДЕЛЕНИЕ КОДИРОВКИ ==========
+
+EncodingGuess EncodingUtils::detect_encoding(const char* data, size_t size, TextEncoding fallback) {
+    if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        return { TextEncoding::Utf8, true };
+    }
+
+    ByteClasses classes;
+    countClasses(data, size, classes);
+    if (classes.high == 0) {
+        return { fallback, false };  // ASCII одинаков в обеих кодировках
+    }
+
+    // Края образца могли разрезать символ - проверяется только часть из целых символов.
+    // Русский текст CP-1251 почти никогда не является корректным UTF-8: строчные буквы
+    // 0xE0-0xFF - ведущие байты трёхбайтовых последовательностей
+    size_t begin = utf8_sequence_start(data, size);
+    size_t end = utf8_complete_prefix(data, size);
+    if (begin < end && is_valid_utf8(data + begin, end - begin)) {
+        return { TextEncoding::Utf8, true };
+    }
+
+    // Некорректный UTF-8: текст CP-1251, если не меньше 60% старших байтов - буквы.
+    // Иначе это может быть и повреждённый UTF-8, но декодер UTF-8 заменил бы испорченные
+    // байты, а CP-1251 читает любой байт - это догадка, а не определённая кодировка
+    size_t letters = classes.high - classes.continuation + classes.yo;
+    return { TextEncoding::Cp1251, letters * 5 >= classes.high * 3 };
+}
@@ -1,14 +1,67 @@
 #pragma once
 #include <string>
-#include <windows.h>
-#include <vector>
+#include <cstddef>
 
+//    (    )
+enum class TextEncoding {
+    Cp1251,
+    Utf8
+};
+
+//     
+struct EncodingGuess {
+    TextEncoding encoding;  // ,      
+    bool certain;           //      ( - )
+};
+
+//  CP-1251 <-> UTF-8  Win32:   CP-1251 
+//   128 ,  ASCII   16   .
+// ,     ,   
+// UTF-8   '?'.
 class EncodingUtils {
 public:
+    //    UTF-8    CP-1251 (   )
+    static const size_t MAX_UTF8_PER_CP1251 = 3;
+
     //   
     static std::string cp1251_to_utf8(const std::string& cp1251);
     static std::string utf8_to_cp1251(const std::string& utf8);
 
+    //    ,    
+    //  cp1251_to_utf8  dst   size * MAX_UTF8_PER_CP1251 ,  utf8_to_cp1251 - size
+    static size_t cp1251_to_utf8(const char* src, size_t size, char* dst);
+    static size_t utf8_to_cp1251(const char* src, size_t size, char* dst);
+
+    //         ( - )
+    //  dst   max_transcoded_size(from, to, size) 
+    static size_t transcode(TextEncoding from, TextEncoding to, const char* src, size_t size, char* dst);
+    static size_t max_transcoded_size(TextEncoding from, TextEncoding to, size_t size);
+
+    //         UTF-8 (  :
+    //     )
+    static size_t utf8_complete_prefix(const char* data, size_t size);
+
+    //   ,     UTF-8 (  3): 
+    //    ,    
+    static size_t utf8_sequence_start(const char* data, size_t size);
+
     // 
+    //  -  UTF-8 ( ,   );  AVX2 
+    //  32     
     static bool is_valid_utf8(const std::string& str);
-};
\ No newline at end of file
+    static bool is_valid_utf8(const char* data, size_t size);
+
+    //      (    )
+    static bool is_valid_utf8_scalar(const char* data, size_t size);
+
+    //  
+    //    :     ,    
+    static const size_t DETECTION_WINDOW = 32 * 1024;
+
+    //   : BOM   UTF-8 - UTF-8;  UTF-8, 
+    //    60%   -  0xC0-0xFF, -   CP-1251.
+    //  UTF-8    UTF-8:     
+    // CP-1251 (    - )  certain = false.    ASCII
+    //   - fallback  certain = false
+    static EncodingGuess detect_encoding(const char* data, size_t size, TextEncoding fallback);
+};
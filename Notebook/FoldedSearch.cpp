@@ -0,0 +1,208 @@
+﻿#include "FoldedSearch.h"
+#include "CaseFolding.h"
+#include "CpuFeatures.h"
+
+// Векторные ядра собираются только для x64: там SSE2 есть всегда, AVX2 проверяется при запуске
+#if defined(_M_X64) || defined(__x86_64__)
+#define FOLDED_SEARCH_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FOLDED_SEARCH_AVX2
+#else
+#define FOLDED_SEARCH_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace FoldedSearch {
+
+    namespace {
+
+        // ========== СКАЛЯРНОЕ ЯДРО ==========
+
+        // Средняя часть кандидата: первый и последний символы уже совпали
+        inline bool equalsFolded(const char* text, const char* pattern, size_t length) {
+            for (size_t i = 0; i < length; ++i) {
+                if (CaseFolding::foldCp1251(text[i]) != pattern[i]) return false;
+            }
+            return true;
+        }
+
+        size_t findScalar(std::string_view text, std::string_view pattern) {
+            if (pattern.empty()) return 0;
+            if (pattern.size() > text.size()) return npos;
+
+            const char first = pattern[0];
+            const size_t last = text.size() - pattern.size();
+            for (size_t i = 0; i <= last; ++i) {
+                if (CaseFolding::foldCp1251(text[i]) == first &&
+                    equalsFolded(text.data() + i + 1, pattern.data() + 1, pattern.size() - 1)) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+#ifdef FOLDED_SEARCH_X64
+
+        inline unsigned lowestBit(unsigned mask) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return (unsigned)index;
+#else
+            return (unsigned)__builtin_ctz(mask);
+#endif
+        }
+
+        // Проверка совпавших по краям позиций; mask - биты позиций блока, начинающегося с base
+        inline size_t verifyCandidates(unsigned mask, const char* data, size_t base, std::string_view pattern) {
+            const size_t middle = pattern.size() > 2 ? pattern.size() - 2 : 0;
+            while (mask != 0) {
+                unsigned bit = lowestBit(mask);
+                if (equalsFolded(data + base + bit + 1, pattern.data() + 1, middle)) {
+                    return base + bit;
+                }
+                mask &= mask - 1;
+            }
+            return npos;
+        }
+
+        // Остаток текста, в который не помещается целый блок, проверяется скалярно
+        inline size_t findTail(std::string_view text, size_t from, std::string_view pattern) {
+            size_t found = findScalar(text.substr(from), pattern);
+            return found == npos ? npos : from + found;
+        }
+
+        // ========== ЯДРО SSE2 ==========
+
+        // Нижний регистр для 16 байт: A-Z и А-Я (0xC0-0xDF) +0x20, Ё (0xA8) +0x10
+        // Диапазоны проверяются знаковым сравнением после сдвига начала диапазона к -128
+        inline __m128i fold16(__m128i v) {
+            const __m128i latin = _mm_cmpgt_epi8(_mm_set1_epi8((char)(-128 + 26)),
+                _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - 'A'))));
+            const __m128i cyrillic = _mm_cmpgt_epi8(_mm_set1_epi8((char)(-128 + 32)),
+                _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - 0xC0))));
+            const __m128i yo = _mm_cmpeq_epi8(v, _mm_set1_epi8((char)0xA8));
+            const __m128i shift = _mm_or_si128(
+                _mm_and_si128(_mm_or_si128(latin, cyrillic), _mm_set1_epi8(0x20)),
+                _mm_and_si128(yo, _mm_set1_epi8(0x10)));
+            return _mm_add_epi8(v, shift);
+        }
+
+        size_t findSse2(std::string_view text, std::string_view pattern) {
+            const size_t n = pattern.size();
+            if (n == 0) return 0;
+            if (n > text.size()) return npos;
+
+            const __m128i first = _mm_set1_epi8(pattern[0]);
+            const __m128i last = _mm_set1_epi8(pattern[n - 1]);
+            const char* data = text.data();
+
+            size_t i = 0;
+            for (; i + n - 1 + 16 <= text.size(); i += 16) {
+                __m128i head = fold16(_mm_loadu_si128((const __m128i*)(data + i)));
+                __m128i tail = fold16(_mm_loadu_si128((const __m128i*)(data + i + n - 1)));
+                unsigned mask = (unsigned)_mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+                if (mask != 0) {
+                    size_t found = verifyCandidates(mask, data, i, pattern);
+                    if (found != npos) return found;
+                }
+            }
+            return findTail(text, i, pattern);
+        }
+
+        // ========== ЯДРО AVX2 ==========
+
+        FOLDED_SEARCH_AVX2 inline __m256i fold32(__m256i v) {
+            const __m256i latin = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + 26)),
+                _mm256_add_epi8(v, _mm256_set1_epi8((char)(0x80 - 'A'))));
+            const __m256i cyrillic = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + 32)),
+                _mm256_add_epi8(v, _mm256_set1_epi8((char)(0x80 - 0xC0))));
+            const __m256i yo = _mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)0xA8));
+            const __m256i shift = _mm256_or_si256(
+                _mm256_and_si256(_mm256_or_si256(latin, cyrillic), _mm256_set1_epi8(0x20)),
+                _mm256_and_si256(yo, _mm256_set1_epi8(0x10)));
+            return _mm256_add_epi8(v, shift);
+        }
+
+        FOLDED_SEARCH_AVX2 size_t findAvx2(std::string_view text, std::string_view pattern) {
+            const size_t n = pattern.size();
+            if (n == 0) return 0;
+            if (n > text.size()) return npos;
+
+            const __m256i first = _mm256_set1_epi8(pattern[0]);
+            const __m256i last = _mm256_set1_epi8(pattern[n - 1]);
+            const char* data = text.data();
+
+            size_t i = 0;
+            for (; i + n - 1 + 32 <= text.size(); i += 32) {
+                __m256i head = fold32(_mm256_loadu_si256((const __m256i*)(data + i)));
+                __m256i tail = fold32(_mm256_loadu_si256((const __m256i*)(data + i + n - 1)));
+                unsigned mask = (unsigned)_mm256_movemask_epi8(
+                    _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+                if (mask != 0) {
+                    size_t found = verifyCandidates(mask, data, i, pattern);
+                    if (found != npos) return found;
+                }
+            }
+            // Остаток короче 32 байт досматривает ядро SSE2
+            size_t found = findSse2(text.substr(i), pattern);
+            return found == npos ? npos : i + found;
+        }
+
+#endif // FOLDED_SEARCH_X64
+
+        typedef size_t (*FindFunction)(std::string_view, std::string_view);
+
+        FindFunction functionFor(Kernel kernel) {
+#ifdef FOLDED_SEARCH_X64
+            if (kernel == Kernel::Avx2 && isSupported(Kernel::Avx2)) return findAvx2;
+            if (kernel == Kernel::Sse2 || kernel == Kernel::Avx2) return findSse2;
+#endif
+            (void)kernel;
+            return findScalar;
+        }
+
+    } // namespace
+
+    bool isSupported(Kernel kernel) {
+        switch (kernel) {
+        case Kernel::Scalar:
+            return true;
+#ifdef FOLDED_SEARCH_X64
+        case Kernel::Sse2:
+            return true;
+        case Kernel::Avx2:
+            return CpuFeatures::hasAvx2();
+#endif
+        default:
+            return false;
+        }
+    }
+
+    Kernel activeKernel() {
+        if (isSupported(Kernel::Avx2)) return Kernel::Avx2;
+        if (isSupported(Kernel::Sse2)) return Kernel::Sse2;
+        return Kernel::Scalar;
+    }
+
+    const char* kernelName(Kernel kernel) {
+        switch (kernel) {
+        case Kernel::Sse2: return "SSE2";
+        case Kernel::Avx2: return "AVX2";
+        default: return "скалярное";
+        }
+    }
+
+    size_t find(std::string_view text, std::string_view foldedPattern) {
+        static const FindFunction function = functionFor(activeKernel());
+        return function(text, foldedPattern);
+    }
+
+    size_t find(std::string_view text, std::string_view foldedPattern, Kernel kernel) {
+        return functionFor(kernel)(text, foldedPattern);
+    }
+
+} // namespace FoldedSearch
@@ -0,0 +1,40 @@
+// FoldedSearch.h
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+
+//      CP-1251  
+//     ,      
+// (CaseFolding::toLowerCp1251).       :
+// AVX2  SSE2         32  16
+//  ,       .
+namespace FoldedSearch {
+
+    const size_t npos = std::string_view::npos;
+
+    enum class Kernel {
+        Scalar,  //   ( )
+        Sse2,    // 16   
+        Avx2     // 32   
+    };
+
+    //      npos -    
+    size_t find(std::string_view text, std::string_view foldedPattern);
+
+    inline bool contains(std::string_view text, std::string_view foldedPattern) {
+        return find(text, foldedPattern) != npos;
+    }
+
+    //     (   );    
+    size_t find(std::string_view text, std::string_view foldedPattern, Kernel kernel);
+
+    //      
+    bool isSupported(Kernel kernel);
+
+    // ,   find
+    Kernel activeKernel();
+
+    const char* kernelName(Kernel kernel);
+
+} // namespace FoldedSearch
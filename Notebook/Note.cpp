@@ -1,15 +1,22 @@
 #include "Note.h"
+#include "CaseFolding.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <ctime>
+#include <utility>
 
 Note::Note() {
     initTime();
 }
 
-Note::Note(const std::string& author, const std::string& title, const std::string& content)
-    : author(author), title(title), content(content) {
+Note::Note(std::string author, std::string title, std::string content)
+    : author(SymbolTable::authors().intern(author)), title(std::move(title)), content(std::move(content)) {
+    initTime();
+}
+
+Note::Note(SymbolId author, std::string title, std::string content)
+    : author(author), title(std::move(title)), content(std::move(content)) {
     initTime();
 }
 
@@ -35,9 +42,38 @@ void Note::initTime() {
 
 void Note::updateTime() {
     updatedTime = time(nullptr);
+    //      -      
+    folded.reset();
+}
+
+const Note::FoldedFields& Note::getFolded(TextEncoding encoding) const {
+    std::shared_ptr<const FoldedFields> cached = std::atomic_load(&folded);
+    if (cached && cached->encoding == encoding) {
+        return *cached;
+    }
+
+    auto built = std::make_shared<FoldedFields>();
+    built->title = CaseFolding::toLower(title, encoding);
+    built->content = CaseFolding::toLower(content, encoding);
+    built->encoding = encoding;
+
+    //       -  ,
+    //   :   ,    .
+    //      (    )
+    std::shared_ptr<const FoldedFields> expected = cached;
+    std::shared_ptr<const FoldedFields> result = built;
+    if (!std::atomic_compare_exchange_strong(&folded, &expected, result)) {
+        return *expected;
+    }
+    return *built;
 }
 
 void Note::setAuthor(const std::string& newAuthor) {
+    author = SymbolTable::authors().intern(newAuthor);
+    updateTime();
+}
+
+void Note::setAuthorId(SymbolId newAuthor) {
     author = newAuthor;
     updateTime();
 }
@@ -53,13 +89,23 @@ void Note::setContent(const std::string& newContent) {
 }
 
 void Note::setTags(const std::vector<std::string>& newTags) {
-    tags = newTags;
+    SymbolTable& table = SymbolTable::tags();
+    tags.clear();
+    tags.reserve(newTags.size());
+    for (const auto& tag : newTags) {
+        tags.push_back(table.intern(tag));
+    }
+    updateTime();
+}
+
+void Note::setTagIds(std::vector<SymbolId> newTags) {
+    tags = std::move(newTags);
     updateTime();
 }
 
 void Note::print() const {
     std::cout << "=== " << title << " ===" << std::endl;
-    std::cout << ": " << author << std::endl;
+    std::cout << ": " << getAuthor() << std::endl;
 
     //  
     char createdBuffer[80];
@@ -82,7 +128,7 @@ void Note::print() const {
     if (!tags.empty()) {
         std::cout << ": ";
         for (size_t i = 0; i < tags.size(); ++i) {
-            std::cout << "#" << tags[i];
+            std::cout << "#" << SymbolTable::tags().name(tags[i]);
             if (i < tags.size() - 1) std::cout << ", ";
         }
         std::cout << std::endl;
@@ -91,7 +137,7 @@ void Note::print() const {
 
 std::string Note::getStorageInfo() const {
     //   -   
-    return "Storable[Note]: \"" + title + "\" by " + author;
+    return "Storable[Note]: \"" + title + "\" by " + getAuthor();
 }
 
 void Note::markUpdated() {
@@ -1,37 +1,76 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <memory>
 #include <ctime>
+#include <cstdint>
 #include "Storable.h"
+#include "SymbolTable.h"
+#include "EncodingUtils.h"
+
+//   :      
+typedef uint64_t NoteId;
 
 class Note : public Storable {
 private:
-    std::string author;
+    NoteId id = 0;  // 0 -      
+    SymbolId author = SymbolTable::EMPTY;  //    -    
     std::string title;
     std::string content;
-    std::vector<std::string> tags;
+    std::vector<SymbolId> tags;
     time_t createdTime;
     time_t updatedTime;
 
+public:
+    //       -    
+    struct FoldedFields {
+        std::string title;
+        std::string content;
+        TextEncoding encoding;  // ,    
+    };
+
+private:
+    //         ;
+    //    ,      .  - 
+    //      ,    
+    mutable std::shared_ptr<const FoldedFields> folded;
+
 public:
     // 
     Note();
-    Note(const std::string& author, const std::string& title, const std::string& content);
+    Note(std::string author, std::string title, std::string content);
+    //  -    SymbolTable::authors():   
+    // (   ,   -  )
+    Note(SymbolId author, std::string title, std::string content);
 
-    // 
-    std::string getAuthor() const { return author; }
-    std::string getTitle() const { return title; }
-    std::string getContent() const { return content; }
-    std::vector<std::string> getTags() const { return tags; }
+    //       ;  ,
+    //        (  - )
+    NoteId getId() const { return id; }
+    const std::string& getAuthor() const { return SymbolTable::authors().name(author); }
+    const std::string& getTitle() const { return title; }
+    const std::string& getContent() const { return content; }
     time_t getCreatedTime() const { return createdTime; }
     time_t getUpdatedTime() const { return updatedTime; }
     std::string getCreatedDate() const;  //     "--"
 
+    //      SymbolTable::authors()  SymbolTable::tags()
+    //   - SymbolTable::tags().name(id),   
+    SymbolId getAuthorId() const { return author; }
+    const std::vector<SymbolId>& getTagIds() const { return tags; }
+
+    //     (CaseFolding::toLower   );  
+    //        .  ,  
+    //     
+    const FoldedFields& getFolded(TextEncoding encoding = TextEncoding::Cp1251) const;
+
     // 
+    void setId(NoteId newId) { id = newId; }
     void setAuthor(const std::string& newAuthor);
     void setTitle(const std::string& newTitle);
     void setContent(const std::string& newContent);
     void setTags(const std::vector<std::string>& newTags);
+    void setAuthorId(SymbolId newAuthor);
+    void setTagIds(std::vector<SymbolId> newTags);
     void setCreatedTime(time_t time) { createdTime = time; }
     void setUpdatedTime(time_t time) { updatedTime = time; }
 
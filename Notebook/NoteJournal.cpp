@@ -0,0 +1,236 @@
+﻿#include "NoteJournal.h"
+#include "NoteSerializer.h"
+#include "BinaryIO.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+
+using namespace BinaryIO;
+
+namespace {
+
+    const char JOURNAL_MAGIC[4] = { 'N', 'B', 'K', 'J' };
+
+} // namespace
+
+// ========== ЗАПИСЬ ИЗМЕНЕНИЙ ==========
+
+void NoteJournal::recordAdd(const Note& note) {
+    record(Operation::Add, 0, &note);
+}
+
+void NoteJournal::recordUpdate(NoteId id, const Note& note) {
+    record(Operation::Update, id, &note);
+}
+
+void NoteJournal::recordRemove(NoteId id) {
+    record(Operation::Remove, id, nullptr);
+}
+
+void NoteJournal::record(Operation op, NoteId id, const Note* note) {
+    // Без привязки к снимку следующее сохранение всё равно будет полным
+    if (attachedFile.empty()) return;
+
+    std::string payload;
+    if (note) {
+        std::ostringstream data(std::ios::binary);
+        NoteSerializer::writeNote(data, *note);
+        payload = data.str();
+    }
+
+    std::ostringstream entry(std::ios::binary);
+    putU8(entry, (uint8_t)op);
+    NoteId recordId = op == Operation::Add && note ? note->getId() : id;
+    putU64(entry, recordId);
+    if (op == Operation::Add && recordId >= nextId) nextId = recordId + 1;
+    putU32(entry, (uint32_t)payload.size());
+    entry.write(payload.data(), (std::streamsize)payload.size());
+
+    pending += entry.str();
+    ++pendingCount;
+}
+
+void NoteJournal::flush() {
+    if (attachedFile.empty()) {
+        throw std::runtime_error("Journal is not attached to a snapshot");
+    }
+    if (headerWritten && pendingCount == 0) return;
+
+    std::string journalFile = journalFileName(attachedFile);
+    std::ofstream file(journalFile, std::ios::binary | (headerWritten ? std::ios::app : std::ios::trunc));
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open journal for writing: " + journalFile);
+    }
+
+    if (!headerWritten) {
+        file.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        putU16(file, VERSION);
+        putU16(file, 0);  // флаги зарезервированы
+        putU64(file, snapshotGeneration);
+        putU64(file, nextId);
+    }
+
+    file.write(pending.data(), (std::streamsize)pending.size());
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Cannot write journal: " + journalFile);
+    }
+
+    headerWritten = true;
+    recordCount += pendingCount;
+    pending.clear();
+    pendingCount = 0;
+}
+
+// ========== ПРИВЯЗКА К СНИМКУ ==========
+
+bool NoteJournal::isAttachedTo(const std::string& snapshotFile) const {
+    return !attachedFile.empty() && attachedFile == snapshotFile;
+}
+
+void NoteJournal::reset(const std::string& snapshotFile, const SnapshotInfo& snapshot) {
+    attachedFile = snapshotFile;
+    snapshotGeneration = snapshot.generation;
+    nextId = snapshot.nextId;
+    headerWritten = false;
+    pending.clear();
+    pendingCount = 0;
+    recordCount = 0;
+
+    // Сразу записываем пустой журнал, чтобы старые записи не применились к новому снимку
+    flush();
+}
+
+void NoteJournal::detach() {
+    attachedFile.clear();
+    headerWritten = false;
+    pending.clear();
+    pendingCount = 0;
+    recordCount = 0;
+}
+
+void NoteJournal::replay(const std::string& snapshotFile, const SnapshotInfo& snapshot, std::vector<Note>& notes) {
+    detach();
+    attachedFile = snapshotFile;
+    snapshotGeneration = snapshot.generation;
+    nextId = snapshot.nextId;
+
+    std::ifstream file(journalFileName(snapshotFile), std::ios::binary);
+    if (!file.is_open()) {
+        // Журнала нет - он будет создан при первом сохранении
+        return;
+    }
+
+    std::stringstream content;
+    content << file.rdbuf();
+    const std::string data = content.str();
+
+    Reader header(data.data(), data.size());
+    if (data.size() < HEADER_SIZE || memcmp(data.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+        return;
+    }
+    header.skip(sizeof(JOURNAL_MAGIC));
+    uint16_t version = header.u16();
+    header.u16();  // флаги
+    uint64_t generation = header.u64();
+    if (version != VERSION || generation != snapshotGeneration) {
+        // Журнал относится к другому снимку - его изменения уже в снимке
+        return;
+    }
+    nextId = (std::max)(nextId, (NoteId)header.u64());
+
+    bool damaged = false;
+    size_t applied = applyById(data, HEADER_SIZE, notes, damaged);
+
+    if (damaged) {
+        // Дописывать за повреждённой записью нельзя - следующее сохранение сделает контрольную точку
+        attachedFile.clear();
+        return;
+    }
+
+    headerWritten = true;
+    recordCount = applied;
+}
+
+uint64_t NoteJournal::storedGeneration(const std::string& snapshotFile) {
+    std::ifstream file(journalFileName(snapshotFile), std::ios::binary);
+    char bytes[HEADER_SIZE];
+    if (!file.read(bytes, (std::streamsize)HEADER_SIZE) || memcmp(bytes, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+        return 0;
+    }
+
+    Reader header(bytes, HEADER_SIZE, sizeof(JOURNAL_MAGIC));
+    uint16_t version = header.u16();
+    header.u16();  // флаги
+    uint64_t generation = header.u64();
+    return version == VERSION ? generation : 0;
+}
+
+// ========== ВОСПРОИЗВЕДЕНИЕ ЗАПИСЕЙ ==========
+
+size_t NoteJournal::applyById(const std::string& data, size_t pos, std::vector<Note>& notes, bool& damaged) {
+    // Позиция заметки по идентификатору; удалённые помечаются и вырезаются в конце одним проходом
+    std::unordered_map<NoteId, size_t> slotById;
+    slotById.reserve(notes.size());
+    for (size_t i = 0; i < notes.size(); ++i) {
+        slotById[notes[i].getId()] = i;
+    }
+    std::vector<bool> removed(notes.size(), false);
+
+    size_t applied = 0;
+
+    while (pos < data.size()) {
+        try {
+            Reader reader(data.data(), data.size(), pos);
+            Operation op = (Operation)reader.u8();
+            NoteId id = reader.u64();
+            uint32_t length = reader.u32();
+            size_t payloadPos = reader.position();
+            reader.skip(length);
+
+            auto found = slotById.find(id);
+            switch (op) {
+            case Operation::Add:
+                if (found != slotById.end()) throw std::runtime_error("Journal note id already exists");
+                notes.push_back(NoteSerializer::readNote(data.data(), payloadPos + length, payloadPos));
+                notes.back().setId(id);
+                slotById[id] = notes.size() - 1;
+                if (id >= nextId) nextId = id + 1;
+                removed.push_back(false);
+                break;
+            case Operation::Update:
+                if (found == slotById.end()) throw std::runtime_error("Journal note id not found");
+                notes[found->second] = NoteSerializer::readNote(data.data(), payloadPos + length, payloadPos);
+                notes[found->second].setId(id);
+                break;
+            case Operation::Remove:
+                if (found == slotById.end()) throw std::runtime_error("Journal note id not found");
+                removed[found->second] = true;
+                slotById.erase(found);
+                break;
+            default:
+                throw std::runtime_error("Unknown journal operation");
+            }
+
+            pos = reader.position();
+            ++applied;
+        }
+        catch (const std::exception&) {
+            // Оборванная или повреждённая запись (например, сбой во время записи)
+            damaged = true;
+            break;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < notes.size(); ++i) {
+        if (removed[i]) continue;
+        if (kept != i) notes[kept] = std::move(notes[i]);
+        ++kept;
+    }
+    notes.resize(kept);
+    return applied;
+}
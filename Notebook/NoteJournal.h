@@ -0,0 +1,92 @@
+// NoteJournal.h
+#pragma once
+
+#include "Note.h"
+#include "NoteSerializer.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+//  NoteJournal -   (write-ahead log)   -
+//        , 
+//     O(),   O( ).
+//      ;  
+//       .
+//
+//   (little-endian):
+//    24 : "NBKJ" | uint16  | uint16  | uint64   |
+//                       uint64      
+//   : uint8  | uint64   | uint32   | 
+//   (SnapshotInfo::generation)     ,
+//    ,    - :    
+// ,     ,       .
+class NoteJournal {
+public:
+    enum class Operation : uint8_t {
+        Add = 1,     //  -  
+        Update = 2,  //  -      
+        Remove = 3   //  
+    };
+
+    static const uint16_t VERSION = 1;
+    static const size_t HEADER_SIZE = 24;
+
+    // ==========   ==========
+
+    //       
+    void recordAdd(const Note& note);
+    void recordUpdate(NoteId id, const Note& note);
+    void recordRemove(NoteId id);
+
+    //      
+    void flush();
+
+    // ==========    ==========
+
+    //          
+    bool isAttachedTo(const std::string& snapshotFile) const;
+
+    //        
+    void reset(const std::string& snapshotFile, const SnapshotInfo& snapshot);
+
+    //  :     
+    void detach();
+
+    //         
+    //  ,         
+    void replay(const std::string& snapshotFile, const SnapshotInfo& snapshot, std::vector<Note>& notes);
+
+    //       (0 -      )
+    //       
+    static uint64_t storedGeneration(const std::string& snapshotFile);
+
+    // ==========  ==========
+
+    //       
+    size_t getRecordCount() const { return recordCount; }
+    size_t getPendingCount() const { return pendingCount; }
+
+    //          ,
+    //    ,  :     
+    NoteId getNextId() const { return nextId; }
+
+    //      
+    static std::string journalFileName(const std::string& snapshotFile) { return snapshotFile + ".journal"; }
+
+private:
+    std::string attachedFile;     // ,     ( -  )
+    uint64_t snapshotGeneration = 0;  //  ,   
+    NoteId nextId = 0;            //   
+    bool headerWritten = false;   //      
+    std::string pending;          //  ,  
+    size_t pendingCount = 0;
+    size_t recordCount = 0;
+
+    void record(Operation op, NoteId id, const Note* note);
+
+    //  ,    pos;    
+    //    ; damaged -    
+    //  nextId   
+    size_t applyById(const std::string& data, size_t pos, std::vector<Note>& notes, bool& damaged);
+};
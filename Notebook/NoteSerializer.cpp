@@ -0,0 +1,577 @@
+﻿#include "NoteSerializer.h"
+#include "BinaryIO.h"
+#include "Parallel.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+#include <charconv>
+#include <unordered_map>
+
+using namespace BinaryIO;
+
+namespace {
+
+    const char BINARY_MAGIC[4] = { 'N', 'B', 'K', 'S' };
+
+    // ========== РАЗБОР ТЕКСТОВОГО ФОРМАТА ==========
+
+    void trim(std::string& str) {
+        str.erase(0, str.find_first_not_of(" \t"));
+        str.erase(str.find_last_not_of(" \t") + 1);
+    }
+
+    // Обрезать пробелы без копирования; '\r' в конце строки - от переводов строк Windows
+    std::string_view trimView(std::string_view str) {
+        if (!str.empty() && str.back() == '\r') str.remove_suffix(1);
+        size_t begin = str.find_first_not_of(" \t");
+        if (begin == std::string_view::npos) return std::string_view();
+        return str.substr(begin, str.find_last_not_of(" \t") - begin + 1);
+    }
+
+    bool startsWith(std::string_view str, std::string_view prefix) {
+        return str.size() >= prefix.size() && memcmp(str.data(), prefix.data(), prefix.size()) == 0;
+    }
+
+    // Разбор метки времени с теми же правилами, что и std::stoll
+    time_t parseTime(std::string_view str, time_t fallback) {
+        size_t begin = str.find_first_not_of(" \t");
+        if (begin == std::string_view::npos) return fallback;
+        str.remove_prefix(begin);
+        if (str[0] == '+') str.remove_prefix(1);
+
+        long long value = 0;
+        auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+        return result.ec == std::errc() ? (time_t)value : fallback;
+    }
+
+    // Разбор идентификатора заметки; 0 - идентификатор отсутствует или повреждён
+    NoteId parseId(std::string_view str) {
+        size_t begin = str.find_first_not_of(" \t");
+        if (begin == std::string_view::npos) return 0;
+        str.remove_prefix(begin);
+
+        unsigned long long value = 0;
+        auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+        return result.ec == std::errc() ? (NoteId)value : 0;
+    }
+
+    // Найти начало строки-заголовка "=== NOTE" не раньше позиции from (или size, если нет)
+    size_t findNoteBoundary(std::string_view text, size_t from) {
+        for (size_t pos = text.find("=== NOTE ", from); pos != std::string_view::npos;
+            pos = text.find("=== NOTE ", pos + 1)) {
+            // Перед заголовком в строке допустимы только пробелы
+            size_t lineStart = pos;
+            while (lineStart > 0 && (text[lineStart - 1] == ' ' || text[lineStart - 1] == '\t')) {
+                --lineStart;
+            }
+            if (lineStart == 0 || text[lineStart - 1] == '\n') {
+                return lineStart < from ? pos : lineStart;
+            }
+        }
+        return text.size();
+    }
+
+    std::vector<SymbolId> internTags(const std::vector<std::string_view>& tags) {
+        SymbolTable& table = SymbolTable::tags();
+        std::vector<SymbolId> ids;
+        ids.reserve(tags.size());
+        for (std::string_view tag : tags) {
+            ids.push_back(table.intern(tag));
+        }
+        return ids;
+    }
+
+    // Авторы и теги одного куска параллельной загрузки: поток разбора интернирует их
+    // без блокировок в свою таблицу (строки - представления в буфере файла), а в общие
+    // таблицы SymbolTable каждая различная строка попадает один раз при слиянии
+    class LocalSymbols {
+    public:
+        SymbolId intern(std::string_view name) {
+            auto inserted = idByName.emplace(name, (SymbolId)names.size());
+            if (inserted.second) {
+                names.push_back(name);
+            }
+            return inserted.first->second;
+        }
+
+        // Локальный идентификатор -> идентификатор в общей таблице
+        std::vector<SymbolId> merge(SymbolTable& table) const {
+            std::vector<SymbolId> global;
+            global.reserve(names.size());
+            for (std::string_view name : names) {
+                global.push_back(table.intern(name));
+            }
+            return global;
+        }
+
+    private:
+        std::unordered_map<std::string_view, SymbolId> idByName;
+        std::vector<std::string_view> names;
+    };
+
+    // Заметки куска с локальными идентификаторами авторов и тегов
+    struct TextPart {
+        std::vector<Note> notes;
+        std::vector<SymbolId> authors;      // локальный автор i-й заметки
+        std::vector<SymbolId> tags;         // локальные теги всех заметок подряд
+        std::vector<size_t> tagBegin;       // теги i-й заметки - tags[tagBegin[i], tagBegin[i + 1])
+        LocalSymbols authorSymbols;
+        LocalSymbols tagSymbols;
+    };
+
+    // Подсчёт заголовков заметок - для резервирования места до разбора
+    size_t countNoteHeaders(std::string_view text) {
+        size_t count = 0;
+        for (size_t pos = text.find("=== NOTE "); pos != std::string_view::npos; pos = text.find("=== NOTE ", pos + 9)) {
+            ++count;
+        }
+        return count;
+    }
+
+    // Разбор текстового формата из буфера. Поля заметки передаются в emit как представления
+    // внутри буфера, поэтому приёмник сам решает, куда их копировать
+    template <typename Emit>
+    void parseTextBuffer(const char* data, size_t size, Emit&& emit) {
+        const time_t now = time(nullptr);
+
+        // Поля текущей заметки - представления внутри буфера, копирует их только приёмник
+        std::string_view currentAuthor, currentTitle, currentContent;
+        std::vector<std::string_view> currentTags;
+        time_t currentCreated = 0, currentUpdated = 0;
+        NoteId currentId = 0;
+        bool inNote = false;
+
+        auto finishNote = [&]() {
+            if (inNote && !currentTitle.empty()) {
+                emit(currentId, currentAuthor, currentTitle, currentContent, currentTags, currentCreated, currentUpdated);
+            }
+        };
+
+        const char* cursor = data;
+        const char* end = data + size;
+
+        while (cursor < end) {
+            const char* newline = (const char*)memchr(cursor, '\n', (size_t)(end - cursor));
+            const char* lineEnd = newline ? newline : end;
+            std::string_view line = trimView(std::string_view(cursor, (size_t)(lineEnd - cursor)));
+            cursor = newline ? newline + 1 : end;
+
+            // Самый короткий префикс поля - "ID: " с хотя бы одной цифрой
+            if (line.size() < 5) continue;
+
+            // Один переход по первому символу вместо цепочки find(...) == 0
+            switch (line[0]) {
+            case '=':
+                if (startsWith(line, "=== NOTE ")) {
+                    // Начало новой заметки
+                    finishNote();
+
+                    inNote = true;
+                    currentId = 0;
+                    currentAuthor = currentTitle = currentContent = std::string_view();
+                    currentTags.clear();
+                    currentCreated = now;
+                    currentUpdated = now;
+                }
+                break;
+            case 'A':
+                if (startsWith(line, "AUTHOR: ")) currentAuthor = line.substr(8);
+                break;
+            case 'I':
+                if (startsWith(line, "ID: ")) currentId = parseId(line.substr(4));
+                break;
+            case 'T':
+                if (startsWith(line, "TITLE: ")) {
+                    currentTitle = line.substr(7);
+                }
+                else if (startsWith(line, "TAGS: ")) {
+                    std::string_view tagsStr = line.substr(6);
+                    while (!tagsStr.empty()) {
+                        size_t comma = tagsStr.find(',');
+                        std::string_view tag = trimView(tagsStr.substr(0, comma));
+                        if (!tag.empty()) currentTags.push_back(tag);
+                        if (comma == std::string_view::npos) break;
+                        tagsStr.remove_prefix(comma + 1);
+                    }
+                }
+                break;
+            case 'C':
+                if (startsWith(line, "CONTENT: ")) {
+                    currentContent = line.substr(9);
+                }
+                else if (startsWith(line, "CREATED: ")) {
+                    currentCreated = parseTime(line.substr(9), now);
+                }
+                break;
+            case 'U':
+                if (startsWith(line, "UPDATED: ")) currentUpdated = parseTime(line.substr(9), now);
+                break;
+            }
+        }
+
+        // Добавляем последнюю заметку
+        finishNote();
+    }
+
+} // namespace
+
+// ========== ТЕКСТОВЫЙ ФОРМАТ ==========
+
+void NoteSerializer::writeTextHeader(std::ostream& out, const SnapshotInfo& info) {
+    out << "=== NOTEBOOK ===\n";
+    out << "GENERATION: " << info.generation << "\n";
+    out << "NEXT ID: " << info.nextId << "\n\n";
+}
+
+void NoteSerializer::writeText(std::ostream& out, const std::vector<Note>& notes) {
+    // Без std::endl: каждый сброс заставил бы TranscodingStreamBuf перекодировать по строке
+    for (size_t i = 0; i < notes.size(); ++i) {
+        const auto& note = notes[i];
+        out << "=== NOTE " << i + 1 << " ===\n";
+        if (note.getId() != 0) out << "ID: " << note.getId() << "\n";
+        out << "AUTHOR: " << note.getAuthor() << "\n";
+        out << "TITLE: " << note.getTitle() << "\n";
+        out << "CONTENT: " << note.getContent() << "\n";
+
+        const auto& tags = note.getTagIds();
+        if (!tags.empty()) {
+            out << "TAGS: ";
+            for (size_t j = 0; j < tags.size(); ++j) {
+                out << SymbolTable::tags().name(tags[j]);
+                if (j < tags.size() - 1) out << ",";
+            }
+            out << "\n";
+        }
+
+        out << "CREATED: " << note.getCreatedTime() << "\n";
+        out << "UPDATED: " << note.getUpdatedTime() << "\n";
+        out << "=== END ===\n\n";
+    }
+}
+
+std::vector<Note> NoteSerializer::readText(std::istream& in) {
+    std::vector<Note> notes;
+    std::string line;
+    std::string currentAuthor, currentTitle, currentContent;
+    std::vector<std::string> currentTags;
+    time_t currentCreated = 0, currentUpdated = 0;
+    NoteId currentId = 0;
+    bool inNote = false;
+
+    while (std::getline(in, line)) {
+        // Удаляем лишние пробелы в начале и конце
+        trim(line);
+
+        if (line.find("=== NOTE ") == 0) {
+            // Начало новой заметки
+            if (inNote && !currentTitle.empty()) {
+                Note note(currentAuthor, currentTitle, currentContent);
+                note.setTags(currentTags);
+                note.setCreatedTime(currentCreated);
+                note.setUpdatedTime(currentUpdated);
+                note.setId(currentId);
+                notes.push_back(note);
+            }
+
+            inNote = true;
+            currentId = 0;
+            currentAuthor.clear();
+            currentTitle.clear();
+            currentContent.clear();
+            currentTags.clear();
+            currentCreated = time(nullptr);
+            currentUpdated = time(nullptr);
+        }
+        else if (line.find("ID: ") == 0) {
+            try {
+                currentId = std::stoull(line.substr(4));
+            }
+            catch (...) {
+                currentId = 0;
+            }
+        }
+        else if (line.find("AUTHOR: ") == 0) {
+            currentAuthor = line.substr(8);
+        }
+        else if (line.find("TITLE: ") == 0) {
+            currentTitle = line.substr(7);
+        }
+        else if (line.find("CONTENT: ") == 0) {
+            currentContent = line.substr(9);
+        }
+        else if (line.find("TAGS: ") == 0) {
+            std::string tagsStr = line.substr(6);
+            if (!tagsStr.empty()) {
+                size_t start = 0;
+                size_t end = 0;
+                while ((end = tagsStr.find(',', start)) != std::string::npos) {
+                    std::string tag = tagsStr.substr(start, end - start);
+                    // Убираем пробелы
+                    trim(tag);
+                    if (!tag.empty()) {
+                        currentTags.push_back(tag);
+                    }
+                    start = end + 1;
+                }
+                // Последний тег
+                std::string lastTag = tagsStr.substr(start);
+                trim(lastTag);
+                if (!lastTag.empty()) {
+                    currentTags.push_back(lastTag);
+                }
+            }
+        }
+        else if (line.find("CREATED: ") == 0) {
+            try {
+                currentCreated = std::stoll(line.substr(9));
+            }
+            catch (...) {
+                currentCreated = time(nullptr);
+            }
+        }
+        else if (line.find("UPDATED: ") == 0) {
+            try {
+                currentUpdated = std::stoll(line.substr(9));
+            }
+            catch (...) {
+                currentUpdated = time(nullptr);
+            }
+        }
+    }
+
+    // Добавляем последнюю заметку
+    if (inNote && !currentTitle.empty()) {
+        Note note(currentAuthor, currentTitle, currentContent);
+        note.setTags(currentTags);
+        note.setCreatedTime(currentCreated);
+        note.setUpdatedTime(currentUpdated);
+        note.setId(currentId);
+        notes.push_back(note);
+    }
+
+    return notes;
+}
+
+std::vector<Note> NoteSerializer::readText(const char* data, size_t size) {
+    // Предварительный подсчёт заголовков избавляет от перемещений Note при росте вектора
+    std::vector<Note> notes;
+    notes.reserve(countNoteHeaders(std::string_view(data, size)));
+
+    parseTextBuffer(data, size, [&](NoteId id, std::string_view author, std::string_view title,
+        std::string_view content, const std::vector<std::string_view>& tags, time_t created, time_t updated) {
+        // Автор и теги интернируются прямо из буфера, без промежуточных строк
+        Note note{ SymbolTable::authors().intern(author), std::string(title), std::string(content) };
+        note.setTagIds(internTags(tags));
+        note.setCreatedTime(created);
+        note.setUpdatedTime(updated);
+        note.setId(id);
+        notes.push_back(std::move(note));
+    });
+
+    return notes;
+}
+
+std::vector<Note> NoteSerializer::readTextParallel(const char* data, size_t size, unsigned threads) {
+    size_t chunkCount = size / PARALLEL_CHUNK_MIN_SIZE;
+    if (chunkCount > threads) chunkCount = threads;
+    if (chunkCount <= 1) {
+        return readText(data, size);
+    }
+
+    // Границы кусков сдвигаются вперёд до ближайшего заголовка заметки
+    std::string_view text(data, size);
+    std::vector<size_t> bounds;
+    bounds.push_back(0);
+    for (size_t i = 1; i < chunkCount; ++i) {
+        size_t bound = findNoteBoundary(text, size / chunkCount * i);
+        if (bound > bounds.back() && bound < size) bounds.push_back(bound);
+    }
+    bounds.push_back(size);
+
+    // Потоки не обращаются к общим таблицам: авторы и теги интернируются в таблицы кусков
+    std::vector<TextPart> parts(bounds.size() - 1);
+    Parallel::forEachTask(parts.size(), [&](size_t i) {
+        TextPart& part = parts[i];
+        const char* partData = data + bounds[i];
+        size_t partSize = bounds[i + 1] - bounds[i];
+        size_t expected = countNoteHeaders(std::string_view(partData, partSize));
+        part.notes.reserve(expected);
+        part.authors.reserve(expected);
+        part.tagBegin.reserve(expected + 1);
+        part.tagBegin.push_back(0);
+
+        parseTextBuffer(partData, partSize, [&](NoteId id, std::string_view author, std::string_view title,
+            std::string_view content, const std::vector<std::string_view>& tags, time_t created, time_t updated) {
+            // Автор - пустой до слияния: общая таблица авторов здесь не блокируется
+            Note note{ SymbolTable::EMPTY, std::string(title), std::string(content) };
+            note.setCreatedTime(created);
+            note.setUpdatedTime(updated);
+            note.setId(id);
+            part.notes.push_back(std::move(note));
+            part.authors.push_back(part.authorSymbols.intern(author));
+            for (std::string_view tag : tags) {
+                part.tags.push_back(part.tagSymbols.intern(tag));
+            }
+            part.tagBegin.push_back(part.tags.size());
+        });
+    }, threads);
+
+    // Склеиваем результаты в исходном порядке, переводя локальные идентификаторы в общие
+    size_t total = 0;
+    for (const auto& part : parts) total += part.notes.size();
+
+    std::vector<Note> notes;
+    notes.reserve(total);
+    for (auto& part : parts) {
+        std::vector<SymbolId> authorIds = part.authorSymbols.merge(SymbolTable::authors());
+        std::vector<SymbolId> tagIds = part.tagSymbols.merge(SymbolTable::tags());
+        for (size_t i = 0; i < part.notes.size(); ++i) {
+            Note& note = part.notes[i];
+            time_t created = note.getCreatedTime();
+            time_t updated = note.getUpdatedTime();
+
+            std::vector<SymbolId> noteTags;
+            noteTags.reserve(part.tagBegin[i + 1] - part.tagBegin[i]);
+            for (size_t t = part.tagBegin[i]; t < part.tagBegin[i + 1]; ++t) {
+                noteTags.push_back(tagIds[part.tags[t]]);
+            }
+            note.setAuthorId(authorIds[part.authors[i]]);
+            note.setTagIds(std::move(noteTags));
+            note.setCreatedTime(created);  // сеттеры выше обновляют время изменения
+            note.setUpdatedTime(updated);
+            notes.push_back(std::move(note));
+        }
+        part = TextPart();
+    }
+    return notes;
+}
+
+// ========== БИНАРНЫЙ ФОРМАТ ==========
+
+void NoteSerializer::writeBinary(std::ostream& out, const std::vector<Note>& notes, const SnapshotInfo& info) {
+    // Фиксированный заголовок
+    out.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    putU16(out, BINARY_VERSION);
+    putU16(out, 0);  // флаги зарезервированы
+    putU64(out, notes.size());
+    putU64(out, info.generation);
+    putU64(out, info.nextId);
+
+    for (const auto& note : notes) {
+        writeNote(out, note);
+    }
+}
+
+std::vector<Note> NoteSerializer::readBinary(const char* data, size_t size) {
+    size_t pos = 0;
+    uint64_t count = readBinaryHeader(data, size, pos);
+
+    std::vector<Note> notes;
+    notes.reserve((size_t)count);
+    for (uint64_t i = 0; i < count; ++i) {
+        notes.push_back(readNote(data, size, pos));
+    }
+
+    return notes;
+}
+
+uint64_t NoteSerializer::readBinaryHeader(const char* data, size_t size, size_t& pos, SnapshotInfo* info) {
+    if (!isBinary(data, size)) {
+        throw std::runtime_error("Not a binary notes file");
+    }
+
+    Reader reader(data, size, sizeof(BINARY_MAGIC));
+    uint16_t version = reader.u16();
+    if (version != BINARY_VERSION) {
+        throw std::runtime_error("Unsupported binary notes file version: " + std::to_string(version));
+    }
+    reader.u16();  // флаги
+    uint64_t count = reader.u64();
+    uint64_t generation = reader.u64();
+    NoteId nextId = reader.u64();
+    if (info) {
+        info->generation = generation;
+        info->nextId = nextId;
+    }
+
+    // Минимальный размер записи: идентификатор + 3 строки + число тегов + 2 метки времени
+    const uint64_t minRecordSize = 8 + 3 * 4 + 4 + 2 * 8;
+    if (count > reader.remaining() / minRecordSize) {
+        throw std::runtime_error("Corrupted binary notes file: invalid note count");
+    }
+
+    pos = reader.position();
+    return count;
+}
+
+void NoteSerializer::writeNote(std::ostream& out, const Note& note) {
+    putU64(out, note.getId());
+    putString(out, note.getAuthor());
+    putString(out, note.getTitle());
+    putString(out, note.getContent());
+
+    const auto& tags = note.getTagIds();
+    putU32(out, (uint32_t)tags.size());
+    for (SymbolId tag : tags) {
+        putString(out, SymbolTable::tags().name(tag));
+    }
+
+    putU64(out, (uint64_t)(int64_t)note.getCreatedTime());
+    putU64(out, (uint64_t)(int64_t)note.getUpdatedTime());
+}
+
+Note NoteSerializer::readNote(const char* data, size_t size, size_t& pos) {
+    Reader reader(data, size, pos);
+    NoteId id = reader.u64();
+
+    SymbolId author = SymbolTable::authors().intern(reader.view());
+    std::string title = reader.str();
+    std::string content = reader.str();
+
+    SymbolTable& tagTable = SymbolTable::tags();
+    uint32_t tagCount = reader.u32();
+    std::vector<SymbolId> tags;
+    tags.reserve(tagCount < reader.remaining() / 4 ? tagCount : reader.remaining() / 4);
+    for (uint32_t j = 0; j < tagCount; ++j) {
+        tags.push_back(tagTable.intern(reader.view()));
+    }
+
+    Note note{ author, std::move(title), std::move(content) };
+    note.setTagIds(std::move(tags));
+    note.setCreatedTime((time_t)(int64_t)reader.u64());
+    note.setUpdatedTime((time_t)(int64_t)reader.u64());
+    note.setId(id);
+
+    pos = reader.position();
+    return note;
+}
+
+bool NoteSerializer::isBinary(const char* data, size_t size) {
+    return size >= BINARY_HEADER_SIZE && memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+}
+
+SnapshotInfo NoteSerializer::readSnapshotInfo(const char* data, size_t size) {
+    SnapshotInfo info;
+    if (isBinary(data, size)) {
+        size_t pos = 0;
+        readBinaryHeader(data, size, pos, &info);
+        return info;
+    }
+
+    // Сведения текстового снимка - в строках до первой заметки
+    const char* cursor = data;
+    const char* end = data + size;
+    while (cursor < end) {
+        const char* newline = (const char*)memchr(cursor, '\n', (size_t)(end - cursor));
+        std::string_view line = trimView(std::string_view(cursor, (size_t)((newline ? newline : end) - cursor)));
+        cursor = newline ? newline + 1 : end;
+
+        if (startsWith(line, "=== NOTE ")) break;
+        if (startsWith(line, "GENERATION: ")) info.generation = parseId(line.substr(12));
+        else if (startsWith(line, "NEXT ID: ")) info.nextId = parseId(line.substr(9));
+    }
+    return info;
+}
@@ -0,0 +1,74 @@
+// NoteSerializer.h
+#pragma once
+
+#include "Note.h"
+#include <vector>
+#include <string>
+#include <iosfwd>
+#include <cstdint>
+#include <cstddef>
+
+//    
+enum class StorageFormat {
+    Text,    //   "=== NOTE n ===" (,  )
+    Binary   //  : ,  ,    
+};
+
+//   ,     
+struct SnapshotInfo {
+    //  :       .
+    //          
+    uint64_t generation = 0;
+
+    //     (0 -  ).  :
+    //      ,     
+    NoteId nextId = 0;
+};
+
+//  NoteSerializer         
+//
+//   (  little-endian):
+//    32 : "NBKS" | uint16  | uint16  | uint64   |
+//                       uint64   | uint64  
+//   : uint64  | str  | str  | str  |
+//            uint32   | str ... | int64  | int64 
+//   str: uint32  |  
+//
+//     "=== NOTEBOOK ===", "GENERATION: n"  "NEXT ID: n";
+//         .
+class NoteSerializer {
+public:
+    static const uint16_t BINARY_VERSION = 1;
+    static const size_t BINARY_HEADER_SIZE = 32;
+
+    //  
+    static void writeText(std::ostream& out, const std::vector<Note>& notes);
+    static void writeTextHeader(std::ostream& out, const SnapshotInfo& info);  //   
+    static std::vector<Note> readText(std::istream& in);   //    
+    static std::vector<Note> readText(const char* data, size_t size);  //    
+
+    //  :       "=== NOTE",  
+    //         (    )
+    static std::vector<Note> readTextParallel(const char* data, size_t size, unsigned threads);
+
+    //      
+    static const size_t PARALLEL_CHUNK_MIN_SIZE = 4 * 1024 * 1024;
+
+    //  
+    static void writeBinary(std::ostream& out, const std::vector<Note>& notes, const SnapshotInfo& info = SnapshotInfo());
+    static std::vector<Note> readBinary(const char* data, size_t size);
+
+    //      (    )
+    static void writeNote(std::ostream& out, const Note& note);
+    static Note readNote(const char* data, size_t size, size_t& pos);
+
+    // ,       
+    static bool isBinary(const char* data, size_t size);
+
+    //         (,   )
+    static SnapshotInfo readSnapshotInfo(const char* data, size_t size);
+
+private:
+    //   ;       
+    static uint64_t readBinaryHeader(const char* data, size_t size, size_t& pos, SnapshotInfo* info = nullptr);
+};
@@ -0,0 +1,75 @@
+﻿#include "NoteStats.h"
+
+NoteStats& NoteStats::operator=(const NoteStats& other) {
+    if (this != &other) {
+        copyFrom(other);
+    }
+    return *this;
+}
+
+void NoteStats::copyFrom(const NoteStats& other) {
+    authors = other.authors;
+    tags = other.tags;
+    authorEntries.assign(other.authorEntries.size(), authors.end());
+    for (size_t id = 0; id < other.authorEntries.size(); ++id) {
+        if (other.authorEntries[id] != other.authors.end()) {
+            authorEntries[id] = authors.find(other.authorEntries[id]->first);
+        }
+    }
+    tagEntries.assign(other.tagEntries.size(), tags.end());
+    for (size_t id = 0; id < other.tagEntries.size(); ++id) {
+        if (other.tagEntries[id] != other.tags.end()) {
+            tagEntries[id] = tags.find(other.tagEntries[id]->first);
+        }
+    }
+}
+
+void NoteStats::rebuild(const std::vector<Note>& notes) {
+    authors.clear();
+    tags.clear();
+    authorEntries.clear();
+    tagEntries.clear();
+    for (const auto& note : notes) {
+        add(note);
+    }
+}
+
+void NoteStats::add(const Note& note) {
+    increment(authors, authorEntries, SymbolTable::authors(), note.getAuthorId());
+    for (SymbolId tag : note.getTagIds()) {
+        increment(tags, tagEntries, SymbolTable::tags(), tag);
+    }
+}
+
+void NoteStats::update(const Note& oldNote, const Note& newNote) {
+    remove(oldNote);
+    add(newNote);
+}
+
+void NoteStats::remove(const Note& note) {
+    decrement(authors, authorEntries, note.getAuthorId());
+    for (SymbolId tag : note.getTagIds()) {
+        decrement(tags, tagEntries, tag);
+    }
+}
+
+void NoteStats::increment(Counts& counts, std::vector<Counts::iterator>& entries,
+    const SymbolTable& table, SymbolId id) {
+    if (id >= entries.size()) {
+        entries.resize((size_t)id + 1, counts.end());
+    }
+    if (entries[id] == counts.end()) {
+        entries[id] = counts.emplace(table.name(id), 0).first;
+    }
+    entries[id]->second++;
+}
+
+void NoteStats::decrement(Counts& counts, std::vector<Counts::iterator>& entries, SymbolId id) {
+    if (id >= entries.size() || entries[id] == counts.end()) return;
+
+    // Авторы и теги без заметок в статистику не попадают
+    if (--entries[id]->second <= 0) {
+        counts.erase(entries[id]);
+        entries[id] = counts.end();
+    }
+}
@@ -0,0 +1,48 @@
+// NoteStats.h
+#pragma once
+
+#include "Note.h"
+#include <string>
+#include <vector>
+#include <map>
+
+//  NoteStats -       
+//       , 
+//        .
+//       " SymbolTable ->  ":
+//      ,    
+//       .
+class NoteStats {
+public:
+    NoteStats() = default;
+    //     ,    
+    NoteStats(const NoteStats& other) { copyFrom(other); }
+    NoteStats& operator=(const NoteStats& other);
+
+    //     
+    void rebuild(const std::vector<Note>& notes);
+
+    //  ,    
+    void add(const Note& note);
+    void update(const Note& oldNote, const Note& newNote);
+    void remove(const Note& note);
+
+    //  ->  
+    const std::map<std::string, int>& getAuthorStats() const { return authors; }
+
+    //  ->  
+    const std::map<std::string, int>& getTagStats() const { return tags; }
+
+private:
+    typedef std::map<std::string, int> Counts;
+
+    Counts authors;
+    Counts tags;
+    std::vector<Counts::iterator> authorEntries;  //   ->  authors  end()
+    std::vector<Counts::iterator> tagEntries;     //   ->  tags  end()
+
+    static void increment(Counts& counts, std::vector<Counts::iterator>& entries,
+        const SymbolTable& table, SymbolId id);
+    static void decrement(Counts& counts, std::vector<Counts::iterator>& entries, SymbolId id);
+    void copyFrom(const NoteStats& other);
+};
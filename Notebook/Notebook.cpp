@@ -1,181 +1,362 @@
 ﻿#include "Notebook.h"
+#include "Parallel.h"
+#include "CaseFolding.h"
+#include "FoldedSearch.h"
+#include "EncodingUtils.h"
+#include "TranscodingStreamBuf.h"
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <ctime>
 #include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cstdio>
+#include <limits>
+#include <functional>
+#include <iterator>
 using namespace std;
 
 // ========== ВСПОМОГАТЕЛЬНЫЕ МЕТОДЫ ==========
 
-std::string Notebook::toLower(const std::string& str) {
-    std::string result = str;
+std::string Notebook::toLower(const std::string& str) const {
+    return CaseFolding::toLower(str, textEncoding);
+}
+
+void Notebook::rebuildIndexes() {
+    // После массовой замены notes не содержит надгробий
+    deadSlots.reset(notes.size());
+    removedIds.clear();
+    if (assignIds()) {
+        // Новых идентификаторов нет в файле - журнал по ним вести нельзя,
+        // следующее сохранение запишет полный снимок
+        journal.detach();
+    }
+    wordIndex.rebuild(notes);
+    trigramIndex.rebuild(notes);
+    tagIndex.rebuild(notes);
+    timeIndex.rebuild(notes);
+    stats.rebuild(notes);
+}
+
+void Notebook::setTextEncoding(TextEncoding encoding) {
+    if (encoding == textEncoding) {
+        return;
+    }
+    textEncoding = encoding;
+
+    // Индексы текста хранят слова и триграммы в нижнем регистре - их ключи меняются целиком
+    compact();
+    wordIndex.setEncoding(encoding);
+    trigramIndex.setEncoding(encoding);
+    tagIndex.setEncoding(encoding);
+    wordIndex.rebuild(notes);
+    trigramIndex.rebuild(notes);
+    tagIndex.rebuild(notes);
+}
 
-    // Для Windows с кодировкой 1251
-    for (char& c : result) {
-        // Русские буквы в верхнем регистре (CP-1251)
-        if (c >= -64 && c <= -33) {  // А-Я
-            c += 32;  // Преобразуем в нижний регистр
+EncodingGuess Notebook::detectFileEncoding(std::istream& file, size_t size) const {
+    const size_t window = EncodingUtils::DETECTION_WINDOW;
+    std::string sample;
+
+    if (size <= window * 3) {
+        sample.resize(size);
+        file.read(&sample[0], (std::streamsize)size);
+        sample.resize((size_t)file.gcount());
+    }
+    else {
+        // Окна склеиваются по границам целых символов UTF-8, иначе стык выглядел бы ошибкой
+        const size_t offsets[] = { 0, size / 2 - window / 2, size - window };
+        std::string chunk(window, '\0');
+        for (size_t offset : offsets) {
+            file.seekg((std::streamoff)offset, std::ios::beg);
+            file.read(&chunk[0], (std::streamsize)window);
+            size_t got = (size_t)file.gcount();
+            size_t begin = offset == 0 ? 0 : EncodingUtils::utf8_sequence_start(chunk.data(), got);
+            size_t end = EncodingUtils::utf8_complete_prefix(chunk.data(), got);
+            if (begin < end) sample.append(chunk, begin, end - begin);
         }
-        else if (c == -88) {  // Ё
-            c = -72;  // ё
+    }
+
+    file.clear();
+    file.seekg(0, std::ios::beg);
+    return EncodingUtils::detect_encoding(sample.data(), sample.size(), fileEncoding);
+}
+
+bool Notebook::assignIds() {
+    NoteId maxId = 0;
+    for (const auto& note : notes) {
+        maxId = (std::max)(maxId, note.getId());
+    }
+    // Идентификаторы не переиспользуются в течение сеанса
+    nextId = (std::max)(nextId, maxId + 1);
+
+    bool assigned = false;
+    slotById.clear();
+    slotById.reserve(notes.size());
+    for (size_t i = 0; i < notes.size(); ++i) {
+        // Файлы старых версий не содержат идентификаторов; повтор означает повреждённый файл
+        if (notes[i].getId() == 0 || !slotById.emplace(notes[i].getId(), i).second) {
+            notes[i].setId(nextId++);
+            slotById.emplace(notes[i].getId(), i);
+            assigned = true;
         }
-        // Английские буквы
-        else if (c >= 'A' && c <= 'Z') {
-            c = c - 'A' + 'a';
+    }
+    return assigned;
+}
+
+std::vector<int> Notebook::toIndices(const std::vector<NoteId>& ids) const {
+    std::vector<int> result;
+    result.reserve(ids.size());
+    for (NoteId id : ids) {
+        auto found = slotById.find(id);
+        if (found != slotById.end()) {
+            result.push_back((int)found->second);
+        }
+    }
+    std::sort(result.begin(), result.end());
+
+    // Позиции в notes -> индексы без учёта надгробий (порядок сохраняется)
+    if (deadSlots.deadCount() != 0) {
+        for (int& index : result) {
+            index = indexOfSlot((size_t)index);
         }
     }
+    return result;
+}
 
+std::vector<NoteId> Notebook::toIds(const std::vector<int>& indices) const {
+    std::vector<NoteId> result;
+    result.reserve(indices.size());
+    for (int index : indices) {
+        result.push_back(notes[slotOf(index)].getId());
+    }
+    std::sort(result.begin(), result.end());
     return result;
 }
 
+std::vector<NoteId> Notebook::liveOnly(std::vector<NoteId> ids) const {
+    if (removedIds.empty()) {
+        return ids;
+    }
+    ids.erase(std::remove_if(ids.begin(), ids.end(),
+        [this](NoteId id) { return slotById.find(id) == slotById.end(); }),
+        ids.end());
+    return ids;
+}
+
+size_t Notebook::slotOf(int index) const {
+    return deadSlots.select((size_t)index);
+}
+
+int Notebook::indexOfSlot(size_t slot) const {
+    return (int)deadSlots.rankOf(slot);
+}
+
+void Notebook::compact() {
+    compactSlots();
+    purgeIndexes();
+}
+
+void Notebook::compactSlots() {
+    if (deadSlots.deadCount() == 0) {
+        return;
+    }
+
+    // Живые заметки сдвигаются к началу одним проходом, меняются только их позиции
+    size_t kept = 0;
+    for (size_t slot = 0; slot < notes.size(); ++slot) {
+        if (notes[slot].getId() == 0) continue;
+        if (kept != slot) {
+            notes[kept] = std::move(notes[slot]);
+            slotById[notes[kept].getId()] = kept;
+        }
+        ++kept;
+    }
+    notes.resize(kept);
+    deadSlots.reset(kept);
+}
+
+void Notebook::purgeIndexes() {
+    if (removedIds.empty()) {
+        return;
+    }
+    std::sort(removedIds.begin(), removedIds.end());
+
+    // Идентификаторы выдаются подряд, поэтому удалённые обычно плотно лежат в своём
+    // диапазоне - проверка по битовой маске дешевле двоичного поиска на каждую запись
+    NoteId first = removedIds.front();
+    NoteId span = removedIds.back() - first + 1;
+    std::function<bool(NoteId)> isRemoved;
+    std::vector<bool> mask;
+    if (span / 64 <= removedIds.size()) {
+        mask.assign((size_t)span, false);
+        for (NoteId id : removedIds) mask[(size_t)(id - first)] = true;
+        isRemoved = [&](NoteId id) { return id >= first && id - first < span && mask[(size_t)(id - first)]; };
+    }
+    else {
+        isRemoved = [&](NoteId id) { return std::binary_search(removedIds.begin(), removedIds.end(), id); };
+    }
+
+    wordIndex.purge(isRemoved);
+    trigramIndex.purge(isRemoved);
+    tagIndex.purge(isRemoved);
+    timeIndex.purge(isRemoved);
+    removedIds.clear();
+}
+
 // ========== ФАЙЛОВЫЕ ОПЕРАЦИИ ==========
 
 void Notebook::saveToFile() {
-    std::ofstream file(filename);
+    // Журнал относится к этому файлу и ещё не разросся - достаточно дописать изменения
+    if (journal.isAttachedTo(filename) &&
+        journal.getRecordCount() + journal.getPendingCount() < checkpointInterval) {
+        journal.flush();
+        return;
+    }
+
+    checkpoint();
+}
+
+void Notebook::checkpoint() {
+    // Снимок содержит только живые заметки
+    compact();
+
+    std::ofstream file(filename, storageFormat == StorageFormat::Binary ? std::ios::binary : std::ios::out);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open file for writing: " + filename);
     }
 
-    // Простой текстовый формат
-    for (size_t i = 0; i < notes.size(); ++i) {
-        const auto& note = notes[i];
-        file << "=== NOTE " << i + 1 << " ===" << std::endl;
-        file << "AUTHOR: " << note.getAuthor() << std::endl;
-        file << "TITLE: " << note.getTitle() << std::endl;
-        file << "CONTENT: " << note.getContent() << std::endl;
-
-        auto tags = note.getTags();
-        if (!tags.empty()) {
-            file << "TAGS: ";
-            for (size_t j = 0; j < tags.size(); ++j) {
-                file << tags[j];
-                if (j < tags.size() - 1) file << ",";
-            }
-            file << std::endl;
-        }
+    // Номер больше, чем у прежнего журнала этого файла: если запись снимка пройдёт,
+    // а обнуление журнала - нет, старый журнал не будет применён к новому снимку
+    SnapshotInfo info;
+    info.generation = (std::max)(snapshotGeneration, NoteJournal::storedGeneration(filename)) + 1;
+    info.nextId = nextId;
 
-        file << "CREATED: " << note.getCreatedTime() << std::endl;
-        file << "UPDATED: " << note.getUpdatedTime() << std::endl;
-        file << "=== END ===" << std::endl << std::endl;
+    if (storageFormat == StorageFormat::Binary) {
+        NoteSerializer::writeBinary(file, notes, info);
+    }
+    else if (fileEncoding == textEncoding) {
+        // Простой текстовый формат
+        NoteSerializer::writeTextHeader(file, info);
+        NoteSerializer::writeText(file, notes);
+    }
+    else {
+        // Текст перекодируется кусками по пути в файл, без перекодированных копий строк
+        TranscodingStreamBuf transcoding(file.rdbuf(), textEncoding, fileEncoding);
+        std::ostream out(&transcoding);
+        NoteSerializer::writeTextHeader(out, info);
+        NoteSerializer::writeText(out, notes);
+        if (!out || !transcoding.finish()) {
+            throw std::runtime_error("Cannot write file: " + filename);
+        }
     }
 
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Cannot write file: " + filename);
+    }
     file.close();
+
+    // Снимок содержит все изменения - начинаем пустой журнал
+    snapshotGeneration = info.generation;
+    journal.reset(filename, info);
 }
 
 void Notebook::loadFromFile() {
-    std::ifstream file(filename);
+    std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         // Если файла нет, это не ошибка
         return;
     }
 
-    notes.clear();
-    std::string line;
-    std::string currentAuthor, currentTitle, currentContent;
-    std::vector<std::string> currentTags;
-    time_t currentCreated = 0, currentUpdated = 0;
-    bool inNote = false;
-
-    while (std::getline(file, line)) {
-        // Удаляем лишние пробелы в начале и конце
-        line.erase(0, line.find_first_not_of(" \t"));
-        line.erase(line.find_last_not_of(" \t") + 1);
-
-        if (line.find("=== NOTE ") == 0) {
-            // Начало новой заметки
-            if (inNote && !currentTitle.empty()) {
-                Note note(currentAuthor, currentTitle, currentContent);
-                note.setTags(currentTags);
-                note.setCreatedTime(currentCreated);
-                note.setUpdatedTime(currentUpdated);
-                notes.push_back(note);
-            }
-
-            inNote = true;
-            currentAuthor.clear();
-            currentTitle.clear();
-            currentContent.clear();
-            currentTags.clear();
-            currentCreated = time(nullptr);
-            currentUpdated = time(nullptr);
-        }
-        else if (line.find("AUTHOR: ") == 0) {
-            currentAuthor = line.substr(8);
-        }
-        else if (line.find("TITLE: ") == 0) {
-            currentTitle = line.substr(7);
-        }
-        else if (line.find("CONTENT: ") == 0) {
-            currentContent = line.substr(9);
-        }
-        else if (line.find("TAGS: ") == 0) {
-            std::string tagsStr = line.substr(6);
-            if (!tagsStr.empty()) {
-                size_t start = 0;
-                size_t end = 0;
-                while ((end = tagsStr.find(',', start)) != std::string::npos) {
-                    std::string tag = tagsStr.substr(start, end - start);
-                    // Убираем пробелы
-                    tag.erase(0, tag.find_first_not_of(" \t"));
-                    tag.erase(tag.find_last_not_of(" \t") + 1);
-                    if (!tag.empty()) {
-                        currentTags.push_back(tag);
-                    }
-                    start = end + 1;
-                }
-                // Последний тег
-                std::string lastTag = tagsStr.substr(start);
-                lastTag.erase(0, lastTag.find_first_not_of(" \t"));
-                lastTag.erase(lastTag.find_last_not_of(" \t") + 1);
-                if (!lastTag.empty()) {
-                    currentTags.push_back(lastTag);
-                }
-            }
-        }
-        else if (line.find("CREATED: ") == 0) {
-            try {
-                currentCreated = std::stoll(line.substr(9));
-            }
-            catch (...) {
-                currentCreated = time(nullptr);
-            }
-        }
-        else if (line.find("UPDATED: ") == 0) {
-            try {
-                currentUpdated = std::stoll(line.substr(9));
-            }
-            catch (...) {
-                currentUpdated = time(nullptr);
-            }
+    file.seekg(0, std::ios::end);
+    size_t size = (size_t)file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    // Определяем формат по сигнатуре в начале файла
+    char signature[NoteSerializer::BINARY_HEADER_SIZE] = {};
+    file.read(signature, (std::streamsize)sizeof(signature));
+    bool binary = NoteSerializer::isBinary(signature, (size_t)file.gcount());
+    file.clear();
+    file.seekg(0, std::ios::beg);
+
+    // Архив смешивает файлы CP-1251 и UTF-8 - файл читается в кодировке по образцу, а не
+    // по настройке. Настройку (кодировку следующего сохранения) меняет только однозначный
+    // результат: догадка по повреждённому файлу не должна молча перекодировать его
+    TextEncoding sourceEncoding = fileEncoding;
+    if (!binary && encodingDetection) {
+        EncodingGuess guess = detectFileEncoding(file, size);
+        sourceEncoding = guess.encoding;
+        if (guess.certain) {
+            fileEncoding = guess.encoding;
         }
     }
 
-    // Добавляем последнюю заметку
-    if (inNote && !currentTitle.empty()) {
-        Note note(currentAuthor, currentTitle, currentContent);
-        note.setTags(currentTags);
-        note.setCreatedTime(currentCreated);
-        note.setUpdatedTime(currentUpdated);
-        notes.push_back(note);
+    // BOM UTF-8 не относится к тексту заметок
+    size_t textStart = 0;
+    if (!binary && sourceEncoding == TextEncoding::Utf8 && size >= 3 &&
+        std::memcmp(signature, "\xEF\xBB\xBF", 3) == 0) {
+        textStart = 3;
+        file.seekg(3, std::ios::beg);
     }
 
+    std::string buffer;
+    if (binary || sourceEncoding == textEncoding) {
+        // Файл читается целиком одним последовательным чтением
+        buffer.resize(size - textStart);
+        file.read(&buffer[0], (std::streamsize)buffer.size());
+        buffer.resize((size_t)file.gcount());
+    }
+    else {
+        // Текст перекодируется кусками прямо при чтении
+        // Русский текст в UTF-8 почти вдвое длиннее, чем в CP-1251
+        TranscodingStreamBuf transcoding(file.rdbuf(), sourceEncoding, textEncoding);
+        buffer.resize(textEncoding == TextEncoding::Utf8 ? size * 2 : size);
+        size_t used = 0;
+        while (true) {
+            if (used == buffer.size()) buffer.resize(buffer.size() * 2 + TranscodingStreamBuf::CHUNK_SIZE);
+            std::streamsize got = transcoding.sgetn(&buffer[used], (std::streamsize)(buffer.size() - used));
+            if (got <= 0) break;
+            used += (size_t)got;
+        }
+        buffer.resize(used);
+    }
     file.close();
+
+    if (binary) {
+        notes = NoteSerializer::readBinary(buffer.data(), buffer.size());
+    }
+    else {
+        // Большие файлы разбираются кусками на всех ядрах
+        notes = NoteSerializer::readTextParallel(buffer.data(), buffer.size(), Parallel::workerCount());
+    }
+    SnapshotInfo info = NoteSerializer::readSnapshotInfo(buffer.data(), buffer.size());
+    snapshotGeneration = info.generation;
+
+    // Применяем изменения, сохранённые в журнале после снимка
+    journal.replay(filename, info, notes);
+
+    // Идентификаторы удалённых заметок не выдаются повторно и после перезапуска
+    nextId = (std::max)(nextId, journal.getNextId());
+    rebuildIndexes();
 }
 
 // ========== ОСТАЛЬНЫЕ МЕТОДЫ ==========
 
 void Notebook::printAll() const {
-    if (notes.empty()) {
+    if (getNoteCount() == 0) {
         std::cout << "Заметок пока нет." << std::endl;
         return;
     }
 
     //std::cout << "=== ВСЕ ЗАМЕТКИ ===" << std::endl;
-    for (size_t i = 0; i < notes.size(); ++i) {
-        std::cout << i + 1 << ". " << notes[i].getTitle()
-            << " (автор: " << notes[i].getAuthor() << ")"
+    int number = 0;
+    for (const auto& note : notes) {
+        if (note.getId() == 0) continue;  // Надгробие
+        std::cout << ++number << ". " << note.getTitle()
+            << " (автор: " << note.getAuthor() << ")"
             << std::endl;
     }
 }
@@ -188,37 +369,116 @@ void Notebook::printNotes(const std::vector<int>& indices) const {
 
     std::cout << "=== НАЙДЕННЫЕ ЗАМЕТКИ ===" << std::endl;
     for (int index : indices) {
-        if (index >= 0 && index < (int)notes.size()) {
-            notes[index].print();
+        if (index >= 0 && index < getNoteCount()) {
+            notes[slotOf(index)].print();
             std::cout << std::endl;
         }
     }
 }
 
-void Notebook::addNote(const Note& note) {
+NoteId Notebook::addNote(const Note& note) {
     notes.push_back(note);
+    Note& added = notes.back();
+    added.setId(nextId++);
+    slotById[added.getId()] = notes.size() - 1;
+    deadSlots.append();
+
+    wordIndex.add(added);
+    trigramIndex.add(added);
+    tagIndex.add(added);
+    timeIndex.add(added);
+    stats.add(added);
+    journal.recordAdd(added);
+    return added.getId();
 }
 
 bool Notebook::removeNote(int index) {
-    if (index < 0 || index >= (int)notes.size()) {
+    if (index < 0 || index >= getNoteCount()) {
         return false;
     }
-    notes.erase(notes.begin() + index);
+    removeSlot(slotOf(index));
     return true;
 }
 
-Note* Notebook::getNote(int index) {
-    if (index < 0 || index >= (int)notes.size()) {
+const Note* Notebook::getNote(int index) const {
+    if (index < 0 || index >= getNoteCount()) {
         return nullptr;
     }
-    return &notes[index];
+    return &notes[slotOf(index)];
 }
 
 bool Notebook::updateNote(int index, const Note& updatedNote) {
-    if (index < 0 || index >= (int)notes.size()) {
+    if (index < 0 || index >= getNoteCount()) {
+        return false;
+    }
+    updateSlot(slotOf(index), updatedNote);
+    return true;
+}
+
+void Notebook::updateSlot(size_t slot, const Note& updatedNote) {
+    Note stored = updatedNote;
+    stored.setId(notes[slot].getId());
+
+    wordIndex.update(notes[slot], stored);
+    trigramIndex.update(notes[slot], stored);
+    tagIndex.update(notes[slot], stored);
+    timeIndex.update(notes[slot], stored);
+    stats.update(notes[slot], stored);
+    notes[slot] = std::move(stored);
+    journal.recordUpdate(notes[slot].getId(), notes[slot]);
+}
+
+void Notebook::removeSlot(size_t slot) {
+    NoteId id = notes[slot].getId();
+    stats.remove(notes[slot]);
+    slotById.erase(id);
+
+    // Индексы поиска вычищаются при уплотнении, до него результаты фильтруются по slotById
+    removedIds.push_back(id);
+    deadSlots.kill(slot);
+
+    // Надгробие: пустая заметка с идентификатором 0, строки освобождаются сразу
+    notes[slot] = Note();
+    journal.recordRemove(id);
+
+    // Уплотнение стоит O(n) и запускается после удаления не менее доли compactionRatio
+    if ((double)deadSlots.deadCount() > (double)notes.size() * compactionRatio) {
+        compactSlots();
+    }
+    // Вычистка индексов проходит по всем спискам заметок, поэтому откладывается,
+    // пока удалённых не станет больше, чем живых
+    if (removedIds.size() > (size_t)getNoteCount()) {
+        purgeIndexes();
+    }
+}
+
+// ========== ОПЕРАЦИИ ПО ИДЕНТИФИКАТОРУ ==========
+
+int Notebook::indexOf(NoteId id) const {
+    auto found = slotById.find(id);
+    return found == slotById.end() ? -1 : indexOfSlot(found->second);
+}
+
+const Note* Notebook::getNoteById(NoteId id) const {
+    auto found = slotById.find(id);
+    return found == slotById.end() ? nullptr : &notes[found->second];
+}
+
+bool Notebook::updateNoteById(NoteId id, const Note& updatedNote) {
+    auto found = slotById.find(id);
+    if (found == slotById.end()) {
+        return false;
+    }
+    updateSlot(found->second, updatedNote);
+    return true;
+}
+
+bool Notebook::removeNoteById(NoteId id) {
+    auto found = slotById.find(id);
+    if (found == slotById.end()) {
         return false;
     }
-    notes[index] = updatedNote;
+    removeSlot(found->second);
     return true;
 }
 
@@ -226,98 +486,242 @@ std::vector<int> Notebook::findByAuthor(const std::string& author) const {
     std::vector<int> result;
     std::string searchAuthor = toLower(author);
 
-    for (size_t i = 0; i < notes.size(); ++i) {
-        if (toLower(notes[i].getAuthor()).find(searchAuthor) != std::string::npos) {
-            result.push_back((int)i);
+    // Подстрока проверяется один раз для каждого различного автора,
+    // заметки затем сравниваются по идентификатору автора.
+    // Векторные ядра FoldedSearch приводят регистр по байтам CP-1251. Для образца из ASCII
+    // этого хватает и в UTF-8: байты многобайтовых символов не становятся ASCII. Иначе
+    // образец ищется в именах, приведённых к нижнему регистру UTF-8 при первом таком поиске
+    const SymbolTable& authors = SymbolTable::authors();
+    const bool foldedNames = textEncoding == TextEncoding::Utf8 &&
+        std::any_of(searchAuthor.begin(), searchAuthor.end(), [](char c) { return (unsigned char)c >= 0x80; });
+    std::vector<char> matching(foldedNames ? authors.foldUtf8() : authors.size(), 0);
+    bool any = false;
+    for (size_t id = 0; id < matching.size(); ++id) {
+        if (foldedNames ? authors.foldedUtf8((SymbolId)id).find(searchAuthor) != std::string::npos
+                        : FoldedSearch::contains(authors.name((SymbolId)id), searchAuthor)) {
+            matching[id] = 1;
+            any = true;
         }
     }
-    return result;
+    if (!any) return result;
+
+    return scanNotes([&](const Note& note) {
+        SymbolId id = note.getAuthorId();
+        return id < matching.size() && matching[id] != 0;
+    });
 }
 
-std::vector<int> Notebook::findByTag(const std::string& tag) const {
-    std::vector<int> result;
-    std::string searchTag = toLower(tag);
+std::vector<int> Notebook::findByTag(const std::string& tag, TagMatch mode) const {
+    return toIndices(findIdsByTag(tag, mode));
+}
 
-    for (size_t i = 0; i < notes.size(); ++i) {
-        const auto& tags = notes[i].getTags();
-        for (const auto& t : tags) {
-            if (toLower(t).find(searchTag) != std::string::npos) {
-                result.push_back((int)i);
-                break;
-            }
+std::vector<NoteId> Notebook::findIdsByTag(const std::string& tag, TagMatch mode) const {
+    if (mode == TagMatch::Exact) {
+        return liveOnly(tagIndex.findExact(tag));
+    }
+    // Подстрока проверяется только по словарю различных тегов
+    return liveOnly(tagIndex.findContaining(tag));
+}
+
+std::vector<int> Notebook::findByTags(const std::vector<std::string>& all, const std::vector<std::string>& any,
+    const std::vector<std::string>& none) const {
+    return toIndices(findIdsByTags(all, any, none));
+}
+
+std::vector<NoteId> Notebook::findIdsByTags(const std::vector<std::string>& all, const std::vector<std::string>& any,
+    const std::vector<std::string>& none) const {
+    // Без all и any отбор идёт из всех заметок - только тогда их список и нужен
+    std::vector<NoteId> universe;
+    if (all.empty() && any.empty()) {
+        universe.reserve(notes.size());
+        for (const auto& note : notes) {
+            if (note.getId() != 0) universe.push_back(note.getId());
         }
+        std::sort(universe.begin(), universe.end());
     }
-    return result;
+    return liveOnly(tagIndex.findByTags(all, any, none, universe));
 }
 
-std::vector<int> Notebook::findByWord(const std::string& word) const {
-    std::vector<int> result;
+std::vector<int> Notebook::findByWord(const std::string& word, WordMatch mode) const {
+    if (mode == WordMatch::WholeWord) {
+        return toIndices(wordIndex.find(word));
+    }
+
     std::string searchWord = toLower(word);
+    std::vector<NoteId> found;
+    if (findWordByTrigrams(searchWord, found)) {
+        return toIndices(found);
+    }
+    return scanWord(searchWord);
+}
 
-    for (size_t i = 0; i < notes.size(); ++i) {
-        const auto& note = notes[i];
-        std::string content = toLower(note.getContent());
-        std::string title = toLower(note.getTitle());
+std::vector<NoteId> Notebook::findIdsByWord(const std::string& word, WordMatch mode) const {
+    if (mode == WordMatch::WholeWord) {
+        return liveOnly(wordIndex.find(word));
+    }
 
-        if (content.find(searchWord) != std::string::npos ||
-            title.find(searchWord) != std::string::npos) {
-            result.push_back((int)i);
-        }
+    std::string searchWord = toLower(word);
+    std::vector<NoteId> found;
+    if (findWordByTrigrams(searchWord, found)) {
+        return found;
     }
-    return result;
+    return toIds(scanWord(searchWord));
 }
 
-std::vector<int> Notebook::findByDate(const std::string& date) const {
+std::vector<int> Notebook::findTopByWord(const std::string& query, size_t k) const {
+    // Порядок результата - по оценке, поэтому индексы не сортируются
     std::vector<int> result;
+    for (const ScoredNote& scored : findTopIdsByWord(query, k)) {
+        result.push_back(indexOf(scored.id));
+    }
+    return result;
+}
 
-    // Проверяем формат даты (должен быть ГГГГ-ММ-ДД)
-    if (date.length() != 10 || date[4] != '-' || date[7] != '-') {
-        std::cerr << "Неверный формат даты. Используйте ГГГГ-ММ-ДД" << std::endl;
-        return result;
+std::vector<ScoredNote> Notebook::findTopIdsByWord(const std::string& query, size_t k) const {
+    return wordIndex.rank(query, k, (size_t)getNoteCount(),
+        [this](NoteId id) { return slotById.count(id) != 0; });
+}
+
+bool Notebook::findWordByTrigrams(const std::string& searchWord, std::vector<NoteId>& result) const {
+    // Короткий запрос индекс не сужает
+    if (searchWord.size() < TrigramIndex::MIN_QUERY_LENGTH) {
+        return false;
     }
 
-    for (size_t i = 0; i < notes.size(); ++i) {
-        // Используем новый метод getCreatedDate()
-        if (notes[i].getCreatedDate() == date) {
-            result.push_back(static_cast<int>(i));
+    // Если кандидатов может оказаться больше четверти заметок, последовательный
+    // просмотр дешевле пересечения списков и проверки кандидатов через slotById
+    if (trigramIndex.estimate(searchWord) > (size_t)getNoteCount() / 4) {
+        return false;
+    }
+    std::vector<NoteId> candidates = trigramIndex.candidates(searchWord);
+
+    // Кандидаты содержат все триграммы запроса; подстрока проверяется только у них
+    result.clear();
+    for (NoteId id : candidates) {
+        auto found = slotById.find(id);
+        if (found == slotById.end()) continue;  // Удалена, индекс ещё не вычищен
+
+        const Note::FoldedFields& folded = notes[found->second].getFolded(textEncoding);
+        if (folded.content.find(searchWord) != std::string::npos ||
+            folded.title.find(searchWord) != std::string::npos) {
+            result.push_back(id);
         }
     }
+    return true;
+}
 
-    return result;
+std::vector<int> Notebook::scanWord(const std::string& searchWord) const {
+    return scanNotes([&](const Note& note) {
+        // Теневая копия в нижнем регистре вычисляется один раз на заметку, повторные
+        // запросы сравнивают готовые строки без приведения регистра
+        const Note::FoldedFields& folded = note.getFolded(textEncoding);
+        return folded.content.find(searchWord) != std::string::npos ||
+            folded.title.find(searchWord) != std::string::npos;
+    });
 }
 
-std::vector<int> Notebook::findByLastNDays(int days) const {
-    std::vector<int> result;
-    auto now = time(nullptr);
+template <typename Predicate>
+std::vector<int> Notebook::scanNotes(Predicate matches) const {
+    std::vector<size_t> slots;
 
-    for (size_t i = 0; i < notes.size(); ++i) {
-        auto noteTime = notes[i].getCreatedTime();
-        double diff = difftime(now, noteTime);
-        if (diff <= days * 24 * 60 * 60) {
-            result.push_back((int)i);
+    if (notes.size() < parallelScanThreshold) {
+        for (size_t slot = 0; slot < notes.size(); ++slot) {
+            if (notes[slot].getId() != 0 && matches(notes[slot])) slots.push_back(slot);
         }
     }
+    else {
+        // Несколько кусков на поток: освободившийся поток забирает следующий кусок,
+        // поэтому неравномерные совпадения не оставляют ядра без работы
+        unsigned threads = Parallel::workerCount();
+        size_t chunkCount = (size_t)threads * 4;
+        size_t chunkSize = (notes.size() + chunkCount - 1) / chunkCount;
+        std::vector<std::vector<size_t>> hits(chunkCount);
+        Parallel::forEachTask(chunkCount, [&](size_t chunk) {
+            size_t begin = chunk * chunkSize;
+            size_t end = (std::min)(begin + chunkSize, notes.size());
+            for (size_t slot = begin; slot < end; ++slot) {
+                if (notes[slot].getId() != 0 && matches(notes[slot])) hits[chunk].push_back(slot);
+            }
+        }, threads);
+
+        // Куски склеиваются по порядку - позиции остаются отсортированными
+        size_t total = 0;
+        for (const auto& part : hits) total += part.size();
+        slots.reserve(total);
+        for (const auto& part : hits) slots.insert(slots.end(), part.begin(), part.end());
+    }
+
+    // Позиции в notes -> индексы без учёта надгробий
+    std::vector<int> result;
+    result.reserve(slots.size());
+    for (size_t slot : slots) {
+        result.push_back(indexOfSlot(slot));
+    }
     return result;
 }
 
-// ========== СТАТИСТИКА ==========
+std::vector<NoteId> Notebook::findIdsByAuthor(const std::string& author) const {
+    return toIds(findByAuthor(author));
+}
 
-std::map<std::string, int> Notebook::getAuthorStats() const {
-    std::map<std::string, int> stats;
-    for (const auto& note : notes) {
-        stats[note.getAuthor()]++;
-    }
-    return stats;
+std::vector<int> Notebook::findByDate(const std::string& date) const {
+    return toIndices(findIdsByDate(date));
 }
 
-std::map<std::string, int> Notebook::getTagStats() const {
-    std::map<std::string, int> stats;
-    for (const auto& note : notes) {
-        for (const auto& tag : note.getTags()) {
-            stats[tag]++;
+std::vector<NoteId> Notebook::findIdsByDate(const std::string& date) const {
+    std::vector<NoteId> result;
+
+    // Проверяем формат даты (должен быть ГГГГ-ММ-ДД, только цифры без знака)
+    bool validFormat = date.length() == 10 && date[4] == '-' && date[7] == '-';
+    for (size_t i = 0; validFormat && i < date.length(); ++i) {
+        if (i != 4 && i != 7 && (date[i] < '0' || date[i] > '9')) {
+            validFormat = false;
         }
     }
-    return stats;
+    if (!validFormat) {
+        std::cerr << "Неверный формат даты. Используйте ГГГГ-ММ-ДД" << std::endl;
+        return result;
+    }
+
+    int year = 0, month = 0, day = 0;
+    const char* text = date.c_str();
+    std::from_chars(text, text + 4, year);
+    std::from_chars(text + 5, text + 7, month);
+    std::from_chars(text + 8, text + 10, day);
+
+    // Границы суток в местном времени вычисляются один раз на запрос
+    tm dayStart = {};
+    dayStart.tm_year = year - 1900;
+    dayStart.tm_mon = month - 1;
+    dayStart.tm_mday = day;
+    dayStart.tm_isdst = -1;
+    tm nextDayStart = dayStart;
+    nextDayStart.tm_mday += 1;
+
+    time_t from = mktime(&dayStart);
+    time_t to = mktime(&nextDayStart);
+    if (from == (time_t)-1 || to == (time_t)-1) {
+        return result;
+    }
+
+    // mktime нормализует несуществующие даты (2024-02-30 -> 2024-03-01):
+    // такие даты не принимаем
+    if (dayStart.tm_year != year - 1900 || dayStart.tm_mon != month - 1 || dayStart.tm_mday != day) {
+        std::cerr << "Несуществующая дата: " << date << std::endl;
+        return result;
+    }
+
+    return liveOnly(timeIndex.findCreatedBetween(from, to));
+}
+
+std::vector<int> Notebook::findByLastNDays(int days) const {
+    return toIndices(findIdsByLastNDays(days));
+}
+
+std::vector<NoteId> Notebook::findIdsByLastNDays(int days) const {
+    // Заметки, созданные не раньше чем days суток назад
+    time_t from = time(nullptr) - (time_t)days * 24 * 60 * 60;
+    return liveOnly(timeIndex.findCreatedBetween(from, (std::numeric_limits<time_t>::max)()));
 }
 
 // ========== ТЕСТОВЫЕ СЦЕНАРИИ ==========
@@ -328,7 +732,10 @@ void Notebook::runTestScenarios() {
     // 1. Сохраняем текущие данные перед тестами
     cout << "1. Сохранение текущих данных в файл..." << endl;
     try {
-        saveToFile();
+        // Полный снимок: журнал после него пуст и не остаётся рядом с файлом
+        checkpoint();
+        journal.detach();
+        std::remove(NoteJournal::journalFileName(filename).c_str());
         cout << "   + СОХРАНЕНИЕ: " << notes.size() << " заметок сохранено в файл" << endl;
     }
     catch (const exception& e) {
@@ -339,10 +746,12 @@ void Notebook::runTestScenarios() {
     cout << "\n2. Создание тестовых заметок..." << endl;
 
     // Сохраняем текущие заметки
+    compact();
     vector<Note> originalNotes = notes;
 
     // Очищаем и заполняем тестовыми данными
     notes.clear();
+    journal.detach();  // Тестовые данные не должны попасть в журнал рабочего файла
 
     // Создаем тестовые заметки
     notes.push_back(Note("Катя", "Список покупок", "Молоко, Яйца, Хлеб"));
@@ -357,6 +766,7 @@ void Notebook::runTestScenarios() {
     notes.push_back(Note("Анна", "Рецепт борща", "Свекла, капуста, мясо, сметана"));
     notes.back().setTags({ "кулинария", "рецепт", "обед" });
 
+    rebuildIndexes();
     cout << "   + Создано " << notes.size() << " тестовых заметок" << endl;
 
     // 3. ТЕСТЫ ПОИСКА
@@ -383,6 +793,23 @@ void Notebook::runTestScenarios() {
     if (res3.size() == 1) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
     else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
 
+    // 3.3a Поиск целого слова по индексу
+    cout << "   Поиск целого слова 'ПРОЕКТА' по индексу: ";
+    auto res3w = findByWord("ПРОЕКТА", WordMatch::WholeWord);
+    auto res3p = findByWord("проект", WordMatch::WholeWord);
+    cout << "найдено " << res3w.size() << ", для части слова 'проект' " << res3p.size()
+        << " (ожидается: 1 и 0)" << endl;
+    if (res3w.size() == 1 && res3w == res3 && res3p.empty()) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
+    // 3.3b Ранжированный поиск: слово в заголовке весит больше, чем в содержимом
+    cout << "   Лучшие совпадения для 'роман список': ";
+    auto top2 = findTopByWord("роман список", 5);
+    auto top1 = findTopByWord("роман список", 1);
+    cout << "найдено " << top2.size() << " и " << top1.size() << " при k = 1 (ожидается: 2 и 1)" << endl;
+    if (top2 == vector<int>{ 0, 2 } && top1 == vector<int>{ 0 }) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
     // 3.4 Поиск по слову (регистронезависимый)
     cout << "   Поиск по слову 'ПРОЕКТ' (верхний регистр): ";
     auto res3a = findByWord("ПРОЕКТ");
@@ -397,6 +824,29 @@ void Notebook::runTestScenarios() {
     if (res4.size() == 1) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
     else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
 
+    // 3.5a Точный поиск по тегу без учёта регистра
+    cout << "   Точный поиск по тегу 'РЕЦЕПТ' и 'рец': ";
+    auto res4e = findByTag("РЕЦЕПТ", TagMatch::Exact);
+    auto res4p = findByTag("рец", TagMatch::Exact);
+    cout << "найдено " << res4e.size() << " и " << res4p.size() << " (ожидается: 1 и 0)" << endl;
+    if (res4e == res4 && res4p.empty()) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
+    // 3.5b Набор тегов: все / любой / ни одного
+    cout << "   Набор тегов: ";
+    auto res4all = findByTags({ "РАБОТА", "встреча" });
+    auto res4any = findByTags({}, { "дом", "рецепт", "нет-такого" });
+    auto res4none = findByTags({}, {}, { "дом" });
+    auto res4mix = findByTags({ "работа" }, {}, { "встреча" });
+    cout << "все " << res4all.size() << ", любой " << res4any.size() << ", кроме 'дом' " << res4none.size()
+        << ", работа без встречи " << res4mix.size() << " (ожидается: 1, 2, " << getNoteCount() - 1 << ", 0)" << endl;
+    if (res4all.size() == 1 && res4any.size() == 2 && (int)res4none.size() == getNoteCount() - 1 && res4mix.empty()) {
+        cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    }
+    else {
+        cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+    }
+
     // 3.6 Поиск по несуществующему автору
     cout << "   Поиск по автору 'Иван' (не существует): ";
     auto res5 = findByAuthor("Иван");
@@ -429,6 +879,64 @@ void Notebook::runTestScenarios() {
         cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
     }
 
+    // 3.8б Несуществующие и некорректные даты
+    cout << "   Поиск по несуществующим и некорректным датам: ";
+    bool badDatesRejected = findByDate("2024-02-30").empty() &&
+        findByDate("2024-13-01").empty() &&
+        findByDate("+024-01-01").empty() &&
+        findByDate("-024-01-01").empty() &&
+        findByDate("2024-1a-01").empty();
+    cout << (badDatesRejected ? "отклонены" : "приняты") << endl;
+    if (badDatesRejected) {
+        cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    }
+    else {
+        cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+    }
+
+    // 3.10 Векторные ядра поиска совпадают со скалярным на границах блоков
+    cout << "   Ядра поиска без учёта регистра (активное: "
+        << FoldedSearch::kernelName(FoldedSearch::activeKernel()) << "): ";
+    const std::string alphabet = "аБвГдЕёЁжЗ xYzAb.,Я";
+    const std::string kernelPattern = CaseFolding::toLowerCp1251("ёЖз Xy");
+    bool kernelsAgree = true;
+    int kernelChecks = 0;
+    for (size_t length = 0; length <= 80 && kernelsAgree; ++length) {
+        for (size_t at = 0; at <= length && kernelsAgree; ++at) {
+            // Текст из повторяющегося алфавита; образец в верхнем регистре вставляется в позицию at
+            std::string text;
+            for (size_t i = 0; i < length; ++i) text += alphabet[(i * 7 + length) % alphabet.size()];
+            if (at + kernelPattern.size() <= length) text.replace(at, kernelPattern.size(), "ЁжЗ xY");
+
+            bool expected = CaseFolding::containsFoldedCp1251(text, kernelPattern);
+            size_t scalar = FoldedSearch::find(text, kernelPattern, FoldedSearch::Kernel::Scalar);
+            for (auto kernel : { FoldedSearch::Kernel::Sse2, FoldedSearch::Kernel::Avx2 }) {
+                kernelsAgree = kernelsAgree && FoldedSearch::find(text, kernelPattern, kernel) == scalar;
+            }
+            kernelsAgree = kernelsAgree && (scalar != FoldedSearch::npos) == expected;
+            ++kernelChecks;
+        }
+    }
+    cout << "проверок " << kernelChecks << endl;
+    if (kernelsAgree) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
+    // 3.11 Параллельный полный просмотр даёт те же результаты, что и последовательный
+    cout << "   Параллельный просмотр против последовательного: ";
+    size_t savedThreshold = parallelScanThreshold;
+    setParallelScanThreshold((numeric_limits<size_t>::max)());
+    auto serialWord = findByWord("ро");
+    auto serialAuthor = findByAuthor("а");
+    setParallelScanThreshold(0);
+    auto parallelWord = findByWord("ро");
+    auto parallelAuthor = findByAuthor("а");
+    setParallelScanThreshold(savedThreshold);
+    cout << "найдено " << parallelWord.size() << " и " << parallelAuthor.size() << endl;
+    if (!serialWord.empty() && parallelWord == serialWord && parallelAuthor == serialAuthor) {
+        cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    }
+    else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
     // 4. ТЕСТЫ СТАТИСТИКИ
     cout << "\n4. Тестирование статистики..." << endl;
 
@@ -457,13 +965,34 @@ void Notebook::runTestScenarios() {
     if (tagTestPassed) cout << "   + ТЕСТ СТАТИСТИКИ ТЕГОВ ПРОЙДЕН" << endl;
     else cout << "   ! ТЕСТ СТАТИСТИКИ ТЕГОВ НЕ ПРОЙДЕН" << endl;
 
+    // 4.3 Интернирование: одинаковые авторы и теги - один идентификатор
+    cout << "   Идентификаторы авторов и тегов: ";
+    auto katyaNotes = findIdsByAuthor("Катя");
+    bool internPassed = katyaNotes.size() == 2;
+    if (internPassed) {
+        const Note* first = getNoteById(katyaNotes[0]);
+        const Note* second = getNoteById(katyaNotes[1]);
+        internPassed = first->getAuthorId() == second->getAuthorId() &&
+            &first->getAuthor() == &second->getAuthor() &&
+            SymbolTable::authors().find("Катя") == (int64_t)first->getAuthorId();
+    }
+    Note tagged("Тест", "Теги", "");
+    tagged.setTags({ "работа", "дом" });
+    const std::vector<SymbolId>& taggedIds = tagged.getTagIds();
+    internPassed = internPassed && taggedIds.size() == 2 &&
+        SymbolTable::tags().name(taggedIds[0]) == "работа" && SymbolTable::tags().name(taggedIds[1]) == "дом" &&
+        taggedIds[0] == (SymbolId)SymbolTable::tags().find("работа");
+    cout << "у заметок Кати общий автор: " << (internPassed ? "да" : "нет") << endl;
+    if (internPassed) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
     // 5. ТЕСТЫ CRUD ОПЕРАЦИЙ
     cout << "\n5. Тестирование CRUD операций..." << endl;
 
     // 5.1 Тест добавления заметки
     cout << "   Тест добавления заметки: ";
     int initialCount = getNoteCount();
-    notes.push_back(Note("Тест", "Тестовая заметка", "Содержимое тестовой заметки"));
+    addNote(Note("Тест", "Тестовая заметка", "Содержимое тестовой заметки"));
     int afterAddCount = getNoteCount();
     cout << "было " << initialCount << ", стало " << afterAddCount << " (ожидается: +1)" << endl;
     if (afterAddCount == initialCount + 1) cout << "   + ТЕСТ ДОБАВЛЕНИЯ ПРОЙДЕН" << endl;
@@ -471,7 +1000,7 @@ void Notebook::runTestScenarios() {
 
     // 5.2 Тест получения заметки
     cout << "   Тест получения заметки по индексу: ";
-    Note* testNote = getNote(0);
+    const Note* testNote = getNote(0);
     if (testNote != nullptr && !testNote->getTitle().empty()) {
         cout << "успешно получена заметка: " << testNote->getTitle() << endl;
         cout << "   + ТЕСТ ПОЛУЧЕНИЯ ПРОЙДЕН" << endl;
@@ -484,12 +1013,37 @@ void Notebook::runTestScenarios() {
     // 5.3 Тест обновления заметки
     cout << "   Тест обновления заметки: ";
     string oldTitle = notes[0].getTitle();
-    notes[0].setTitle("Обновленный заголовок");
+    Note updated = notes[0];
+    updated.setTitle("Обновленный заголовок");
+    updateNote(0, updated);
     string newTitle = notes[0].getTitle();
     cout << "было: \"" << oldTitle << "\", стало: \"" << newTitle << "\"" << endl;
     if (oldTitle != newTitle) cout << "   + ТЕСТ ОБНОВЛЕНИЯ ПРОЙДЕН" << endl;
     else cout << "   ! ТЕСТ ОБНОВЛЕНИЯ НЕ ПРОЙДЕН" << endl;
 
+    // 5.3a Индекс триграмм следует за изменением текста
+    cout << "   Поиск подстроки 'ОБНОВЛЕН' и прежнего заголовка: ";
+    auto foundNew = findByWord("ОБНОВЛЕН");
+    auto foundOld = findByWord(oldTitle);
+    cout << "найдено " << foundNew.size() << " и " << foundOld.size() << " (ожидается: 1 и 0)" << endl;
+    if (foundNew.size() == 1 && foundNew[0] == 0 && foundOld.empty()) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
+    // 5.3b Теневая копия в нижнем регистре сбрасывается сеттерами
+    cout << "   Теневая копия в нижнем регистре: ";
+    Note shadow("Тест", "Заголовок", "СОДЕРЖИМОЕ");
+    const Note::FoldedFields* firstFolded = &shadow.getFolded();
+    bool shadowPassed = firstFolded->content == "содержимое" && &shadow.getFolded() == firstFolded;
+    shadow.setTitle("НОВЫЙ Заголовок");
+    shadowPassed = shadowPassed && shadow.getFolded().title == "новый заголовок";
+    Note shadowCopy = shadow;
+    shadowCopy.setContent("Другое");
+    shadowPassed = shadowPassed && shadowCopy.getFolded().content == "другое" &&
+        shadow.getFolded().content == "содержимое";
+    cout << (shadowPassed ? "обновляется при изменении" : "устарела") << endl;
+    if (shadowPassed) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
     // 5.4 Тест удаления заметки
     cout << "   Тест удаления заметки: ";
     int beforeDeleteCount = getNoteCount();
@@ -504,6 +1058,71 @@ void Notebook::runTestScenarios() {
         cout << "   ! ТЕСТ УДАЛЕНИЯ НЕ ПРОЙДЕН" << endl;
     }
 
+    // 5.5 Статистика обновляется вместе с изменениями
+    cout << "   Тест актуальности статистики после изменений: ";
+    int statsTotal = 0;
+    for (const auto& p : getAuthorStats()) statsTotal += p.second;
+    cout << "заметок в статистике " << statsTotal << " (ожидается: " << getNoteCount() << ")" << endl;
+    if (statsTotal == getNoteCount() && getAuthorStats().count("Тест") == 1) {
+        cout << "   + ТЕСТ СТАТИСТИКИ ПРОЙДЕН" << endl;
+    }
+    else {
+        cout << "   ! ТЕСТ СТАТИСТИКИ НЕ ПРОЙДЕН" << endl;
+    }
+
+    // 5.6 Идентификаторы не меняются при удалении других заметок
+    cout << "   Тест идентификаторов заметок: ";
+    NoteId firstId = addNote(Note("Тест", "Первая по идентификатору", "Удаляется"));
+    NoteId secondId = addNote(Note("Тест", "Вторая по идентификатору", "Остаётся"));
+    removeNoteById(firstId);
+    const Note* byId = getNoteById(secondId);
+    auto idResult = findIdsByWord("остаётся", WordMatch::WholeWord);
+    cout << "после удаления первой найдена вторая: " << (byId ? byId->getTitle() : "нет") << endl;
+    if (byId && byId->getId() == secondId && getNoteById(firstId) == nullptr &&
+        indexOf(secondId) == getNoteCount() - 1 &&
+        idResult.size() == 1 && idResult[0] == secondId) {
+        cout << "   + ТЕСТ ИДЕНТИФИКАТОРОВ ПРОЙДЕН" << endl;
+    }
+    else {
+        cout << "   ! ТЕСТ ИДЕНТИФИКАТОРОВ НЕ ПРОЙДЕН" << endl;
+    }
+    removeNoteById(secondId);
+
+    // 5.7 Удаление оставляет надгробие, которое не видно в поиске и индексах
+    cout << "   Тест удаления надгробием и уплотнения: ";
+    double originalRatio = compactionRatio;
+    setCompactionRatio(1.0);  // Уплотняем вручную
+    int countBefore = getNoteCount();
+    NoteId keptA = addNote(Note("Тест", "Надгробие А", "Соседняя заметка"));
+    NoteId removedB = addNote(Note("Тест", "Надгробие Б", "Удаляемая заметка"));
+    NoteId keptC = addNote(Note("Тест", "Надгробие В", "Соседняя заметка"));
+    NoteId removedD = addNote(Note("Тест", "Надгробие Г", "Удаляемая заметка"));
+    NoteId keptE = addNote(Note("Тест", "Надгробие Д", "Соседняя заметка"));
+    // Удаляем не по порядку позиций - индексы соседей всё равно идут подряд
+    removeNoteById(removedD);
+    removeNoteById(removedB);
+    auto neighboursInOrder = [&]() {
+        int first = indexOf(keptA);
+        return first >= 0 && indexOf(keptC) == first + 1 && indexOf(keptE) == first + 2 &&
+            getNote(first)->getId() == keptA && getNote(first + 1)->getId() == keptC &&
+            getNote(first + 2)->getId() == keptE;
+    };
+    bool tombstoneOk = getNoteCount() == countBefore + 3 && neighboursInOrder() &&
+        indexOf(removedB) == -1 && getNoteById(removedD) == nullptr &&
+        findIdsByWord("удаляемая", WordMatch::WholeWord).empty() &&
+        findByWord("соседняя", WordMatch::WholeWord).size() == 3;
+    compact();
+    bool compactOk = getNoteCount() == countBefore + 3 && neighboursInOrder() &&
+        indexOf(keptE) == getNoteCount() - 1 && getNoteById(removedB) == nullptr &&
+        findByWord("соседняя").size() == 3;
+    cout << "заметок " << getNoteCount() << " (ожидается: " << countBefore + 3 << ")" << endl;
+    if (tombstoneOk && compactOk) cout << "   + ТЕСТ НАДГРОБИЙ ПРОЙДЕН" << endl;
+    else cout << "   ! ТЕСТ НАДГРОБИЙ НЕ ПРОЙДЕН" << endl;
+    removeNoteById(keptA);
+    removeNoteById(keptC);
+    removeNoteById(keptE);
+    setCompactionRatio(originalRatio);
+
     // 6. ТЕСТ ФАЙЛОВЫХ ОПЕРАЦИЙ
     cout << "\n6. Тестирование файловых операций..." << endl;
 
@@ -541,6 +1160,338 @@ void Notebook::runTestScenarios() {
         cout << "   ! ТЕСТ ЗАГРУЗКИ НЕ ПРОЙДЕН" << endl;
     }
 
+    // 6.3 Бинарный снимок: сохранение и загрузка
+    cout << "   Сохранение и загрузка бинарного снимка: ";
+    vector<Note> textNotes = notes;
+    StorageFormat originalFormat = storageFormat;
+    storageFormat = StorageFormat::Binary;
+    filename = "test_notes_backup.bin";
+
+    try {
+        saveToFile();
+        notes.clear();
+        loadFromFile();
+        cout << "загружено " << notes.size() << " (ожидается: " << textNotes.size() << ")" << endl;
+
+        bool same = notes.size() == textNotes.size();
+        for (size_t i = 0; same && i < notes.size(); ++i) {
+            same = notes[i].getId() == textNotes[i].getId() &&
+                notes[i].getTitle() == textNotes[i].getTitle() &&
+                notes[i].getContent() == textNotes[i].getContent() &&
+                notes[i].getTagIds() == textNotes[i].getTagIds() &&
+                notes[i].getCreatedTime() == textNotes[i].getCreatedTime();
+        }
+        if (same && !notes.empty()) {
+            cout << "   + ТЕСТ БИНАРНОГО ФОРМАТА ПРОЙДЕН" << endl;
+        }
+        else {
+            cout << "   ! ТЕСТ БИНАРНОГО ФОРМАТА НЕ ПРОЙДЕН" << endl;
+        }
+    }
+    catch (const exception& e) {
+        cout << "ошибка: " << e.what() << endl;
+        cout << "   ! ТЕСТ БИНАРНОГО ФОРМАТА НЕ ПРОЙДЕН" << endl;
+    }
+    storageFormat = originalFormat;
+
+    // 6.4 Журнал изменений: сохранение одной правки дописывает журнал
+    cout << "   Сохранение правки через журнал: ";
+    try {
+        size_t beforeCount = notes.size();
+        NoteId journalId = addNote(Note("Журнал", "Заметка из журнала", "Добавлена после снимка"));
+        saveToFile();
+        size_t journalRecords = journal.getRecordCount();
+        notes.clear();
+        loadFromFile();
+        cout << "записей в журнале " << journalRecords << ", загружено " << notes.size()
+            << " (ожидается: 1 и " << beforeCount + 1 << ")" << endl;
+        if (journalRecords == 1 && notes.size() == beforeCount + 1 &&
+            notes.back().getAuthor() == "Журнал" && notes.back().getId() == journalId) {
+            cout << "   + ТЕСТ ЖУРНАЛА ПРОЙДЕН" << endl;
+        }
+        else {
+            cout << "   ! ТЕСТ ЖУРНАЛА НЕ ПРОЙДЕН" << endl;
+        }
+    }
+    catch (const exception& e) {
+        cout << "ошибка: " << e.what() << endl;
+        cout << "   ! ТЕСТ ЖУРНАЛА НЕ ПРОЙДЕН" << endl;
+    }
+
+    // 6.4a Сбой между записью снимка и обнулением журнала: старый журнал не применяется,
+    // даже если новый снимок того же размера
+    cout << "   Журнал, не обнулённый после снимка: ";
+    try {
+        checkpoint();
+        Note edited = notes[0];
+        edited.setTitle(string(edited.getTitle().size(), 'x'));  // Та же длина - тот же размер снимка
+        updateNote(0, edited);
+        saveToFile();
+
+        ifstream journalIn(NoteJournal::journalFileName(filename), ios::binary);
+        string oldJournal((istreambuf_iterator<char>(journalIn)), istreambuf_iterator<char>());
+        journalIn.close();
+        ifstream snapshotIn(filename, ios::binary | ios::ate);
+        streamoff oldSize = snapshotIn.tellg();
+        snapshotIn.close();
+
+        checkpoint();
+        ofstream journalOut(NoteJournal::journalFileName(filename), ios::binary | ios::trunc);
+        journalOut.write(oldJournal.data(), (streamsize)oldJournal.size());
+        journalOut.close();
+        snapshotIn.open(filename, ios::binary | ios::ate);
+        bool sameSize = snapshotIn.tellg() == oldSize;
+        snapshotIn.close();
+
+        notes.clear();
+        loadFromFile();
+        size_t replayed = journal.getRecordCount();
+        cout << "снимок того же размера: " << (sameSize ? "да" : "нет") << ", применено записей " << replayed << endl;
+        if (sameSize && replayed == 0 && notes[0].getTitle() == edited.getTitle()) {
+            cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+        }
+        else {
+            cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+        }
+    }
+    catch (const exception& e) {
+        cout << "ошибка: " << e.what() << endl;
+        cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+    }
+
+    // 6.4b Идентификатор удалённой последней заметки не выдаётся после перезапуска -
+    // ни после контрольной точки, ни после сохранения через журнал
+    cout << "   Идентификаторы после перезапуска: ";
+    try {
+        NoteId fromSnapshot = addNote(Note("Журнал", "Удаляемая", "Последняя заметка"));
+        removeNote(indexOf(fromSnapshot));
+        checkpoint();
+        Notebook afterSnapshot;
+        afterSnapshot.filename = filename;
+        afterSnapshot.loadFromFile();
+        afterSnapshot.journal.detach();
+        NoteId snapshotNext = afterSnapshot.addNote(Note("Журнал", "Новая", "После снимка"));
+
+        NoteId fromJournal = addNote(Note("Журнал", "Удаляемая", "Последняя заметка"));
+        removeNote(indexOf(fromJournal));
+        saveToFile();
+        Notebook afterJournal;
+        afterJournal.filename = filename;
+        afterJournal.loadFromFile();
+        afterJournal.journal.detach();
+        NoteId journalNext = afterJournal.addNote(Note("Журнал", "Новая", "После журнала"));
+        compact();
+
+        cout << "удалены " << fromSnapshot << " и " << fromJournal << ", выданы " << snapshotNext
+            << " и " << journalNext << endl;
+        if (snapshotNext > fromSnapshot && journalNext > fromJournal) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+        else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+    }
+    catch (const exception& e) {
+        cout << "ошибка: " << e.what() << endl;
+        cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+    }
+    journal.detach();
+    std::remove("test_notes_backup.txt.journal");
+    std::remove("test_notes_backup.bin");
+    std::remove("test_notes_backup.bin.journal");
+
+    // 6.5 Перекодировка CP-1251 <-> UTF-8 по таблицам
+    cout << "   Перекодировка CP-1251 <-> UTF-8: ";
+    string allBytes;
+    for (int c = 1; c < 256; ++c) allBytes += (char)c;
+    allBytes += string(40, 'x') + "Ёж №5 — €" + string(1, '\0') + "конец";
+    string allUtf8 = EncodingUtils::cp1251_to_utf8(allBytes);
+    bool roundTrip = EncodingUtils::utf8_to_cp1251(allUtf8) == allBytes && EncodingUtils::is_valid_utf8(allUtf8);
+    bool knownBytes = EncodingUtils::cp1251_to_utf8("Ёж №5 — €") ==
+        "\xD0\x81\xD0\xB6 \xE2\x84\x96" "5 \xE2\x80\x94 \xE2\x82\xAC";
+    bool invalidReplaced = EncodingUtils::utf8_to_cp1251("\xD0" "A\xE2\x80") == "?A??" &&
+        !EncodingUtils::is_valid_utf8("\xC0\xAF");
+    cout << allBytes.size() << " байт -> " << allUtf8.size() << " байт UTF-8" << endl;
+    if (roundTrip && knownBytes && invalidReplaced) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
+    // 6.6 Векторная проверка UTF-8 совпадает с последовательным разбором на границах блоков
+    cout << "   Проверка UTF-8 по таблицам: ";
+    bool validatorsAgree = EncodingUtils::is_valid_utf8(string("a\0\xD0\x9F", 4));
+    int validatorChecks = 0;
+    const char* brokenPieces[] = { "\x80", "\xC0\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xE2\x82", "\xF0\x9F\x98\x80" };
+    for (size_t at = 0; at < 70 && validatorsAgree; ++at) {
+        for (const char* piece : brokenPieces) {
+            string text = allUtf8.substr(0, 70);
+            text.insert(at, piece);
+            validatorsAgree = EncodingUtils::is_valid_utf8(text) == EncodingUtils::is_valid_utf8_scalar(text.data(), text.size());
+            ++validatorChecks;
+        }
+    }
+    cout << "проверок " << validatorChecks << endl;
+    if (validatorsAgree) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+    else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
+    // 6.7 Текстовый файл в UTF-8: перекодировка при сохранении и загрузке
+    cout << "   Сохранение и загрузка текста в UTF-8: ";
+    try {
+        vector<Note> cp1251Notes = notes;
+        filename = "test_notes_utf8.txt";
+        journal.detach();
+        setFileEncoding(TextEncoding::Utf8);
+        saveToFile();
+
+        ifstream utf8File(filename, ios::binary);
+        string fileText((istreambuf_iterator<char>(utf8File)), istreambuf_iterator<char>());
+        utf8File.close();
+        bool isUtf8 = EncodingUtils::is_valid_utf8(fileText) &&
+            fileText.find(EncodingUtils::cp1251_to_utf8(cp1251Notes[0].getTitle())) != string::npos;
+
+        notes.clear();
+        loadFromFile();
+        bool same = notes.size() == cp1251Notes.size();
+        for (size_t i = 0; same && i < notes.size(); ++i) {
+            same = notes[i].getId() == cp1251Notes[i].getId() &&
+                notes[i].getAuthor() == cp1251Notes[i].getAuthor() &&
+                notes[i].getTitle() == cp1251Notes[i].getTitle() &&
+                notes[i].getContent() == cp1251Notes[i].getContent() &&
+                notes[i].getTagIds() == cp1251Notes[i].getTagIds() &&
+                notes[i].getCreatedTime() == cp1251Notes[i].getCreatedTime() &&
+                notes[i].getUpdatedTime() == cp1251Notes[i].getUpdatedTime();
+        }
+        cout << "файл " << fileText.size() << " байт, загружено " << notes.size() << endl;
+        if (isUtf8 && same) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+        else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+    }
+    catch (const exception& e) {
+        cout << "ошибка: " << e.what() << endl;
+        cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+    }
+    setFileEncoding(TextEncoding::Cp1251);
+    journal.detach();
+    std::remove("test_notes_utf8.txt");
+    std::remove("test_notes_utf8.txt.journal");
+
+    // 6.8 Поиск без учёта регистра в записной книжке с текстом UTF-8
+    cout << "   Регистр в UTF-8 (кириллица и латиница): ";
+    {
+        vector<Note> cp1251Notes = notes;
+        notes.clear();
+        rebuildIndexes();
+        setTextEncoding(TextEncoding::Utf8);
+
+        auto utf8 = [](const char* text) { return EncodingUtils::cp1251_to_utf8(text); };
+        Note greeting(utf8("Автор"), utf8("ПРИВЕТ, Ёжик"), "Gr\xC3\x9C\xC3\x9F aus M\xC3\x9Cnchen");
+        greeting.setTags({ utf8("Черновик") });
+        addNote(greeting);
+        addNote(Note(utf8("Другой"), utf8("Прочее"), utf8("Совсем другой текст")));
+        addNote(Note("M\xC3\x9Cller Max", utf8("Третья"), ""));
+
+        // Ü (U+00DC) -> ü, Ё -> ё; ß без пары остаётся собой
+        bool folded = CaseFolding::toLowerUtf8("\xC3\x9C\xC3\x9F") == "\xC3\xBC\xC3\x9F" &&
+            CaseFolding::toLowerUtf8(utf8("ЁЖИК Abc")) == utf8("ёжик abc");
+        bool words = findByWord(utf8("привет"), WordMatch::WholeWord).size() == 1 &&
+            findByWord(utf8("ёжик"), WordMatch::WholeWord).size() == 1 &&
+            findByWord("m\xC3\xBCnchen", WordMatch::WholeWord).size() == 1;
+        bool substrings = findByWord(utf8("ЁЖИ")).size() == 1 && findByWord("\xC3\xBCnch").size() == 1 &&
+            findByWord(utf8("ТЕКСТ")).size() == 1;
+        bool others = findByTag(utf8("ЧЕРНОВИК"), TagMatch::Exact).size() == 1 &&
+            findByAuthor(utf8("ДРУГ")).size() == 1 && findByAuthor("MAX").size() == 1 &&
+            findByAuthor("m\xC3\xBCller").size() == 1;
+        cout << (folded ? "таблица" : "-") << ", " << (words ? "слова" : "-") << ", "
+            << (substrings ? "подстроки" : "-") << ", " << (others ? "теги и авторы" : "-") << endl;
+        if (folded && words && substrings && others) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+        else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+
+        notes = cp1251Notes;
+        setTextEncoding(TextEncoding::Cp1251);
+        rebuildIndexes();
+        journal.detach();
+    }
+
+    // 6.9 Определение кодировки файла при загрузке
+    cout << "   Определение кодировки файла: ";
+    try {
+        vector<Note> cp1251Notes = notes;
+        auto sameNotes = [&]() {
+            bool same = notes.size() == cp1251Notes.size();
+            for (size_t i = 0; same && i < notes.size(); ++i) {
+                same = notes[i].getTitle() == cp1251Notes[i].getTitle() &&
+                    notes[i].getContent() == cp1251Notes[i].getContent();
+            }
+            return same;
+        };
+        filename = "test_notes_detect.txt";
+
+        // Файл записан в одной кодировке, а настройка указывает другую
+        journal.detach();
+        setFileEncoding(TextEncoding::Cp1251);
+        saveToFile();
+        setFileEncoding(TextEncoding::Utf8);
+        notes.clear();
+        loadFromFile();
+        bool cp1251Detected = getFileEncoding() == TextEncoding::Cp1251 && sameNotes();
+
+        journal.detach();
+        setFileEncoding(TextEncoding::Utf8);
+        saveToFile();
+        setFileEncoding(TextEncoding::Cp1251);
+        notes.clear();
+        loadFromFile();
+        bool utf8Detected = getFileEncoding() == TextEncoding::Utf8 && sameNotes();
+
+        // Образец из одного ASCII не различается - остаётся заданная кодировка
+        const string ascii = "=== NOTE 1 ===";
+        const string russian = "Съешь же ещё этих мягких французских булок";
+        EncodingGuess asciiGuess = EncodingUtils::detect_encoding(ascii.data(), ascii.size(), TextEncoding::Utf8);
+        EncodingGuess russianGuess = EncodingUtils::detect_encoding(russian.data(), russian.size(), TextEncoding::Utf8);
+        bool samples = asciiGuess.encoding == TextEncoding::Utf8 && !asciiGuess.certain &&
+            russianGuess.encoding == TextEncoding::Cp1251 && russianGuess.certain;
+        const string utf8Russian = EncodingUtils::cp1251_to_utf8(russian);
+        // Окно, разрезавшее первый и последний символы, всё равно распознаётся как UTF-8
+        EncodingGuess cutGuess = EncodingUtils::detect_encoding(utf8Russian.data() + 1, utf8Russian.size() - 2,
+            TextEncoding::Cp1251);
+        samples = samples && cutGuess.encoding == TextEncoding::Utf8 && cutGuess.certain;
+
+        // UTF-8 с выпавшим в середине байтом - некорректный UTF-8: не UTF-8, а догадка CP-1251
+        // (оборванный символ на краю образца считается разрезом окна)
+        string damaged = utf8Russian;
+        damaged.erase(damaged.find('\xD0', damaged.size() / 2), 1);
+        EncodingGuess damagedGuess = EncodingUtils::detect_encoding(damaged.data(), damaged.size(), TextEncoding::Utf8);
+        samples = samples && damagedGuess.encoding == TextEncoding::Cp1251 && !damagedGuess.certain;
+
+        // Такой же файл читается, но кодировка следующего сохранения остаётся заданной
+        journal.detach();
+        setFileEncoding(TextEncoding::Utf8);
+        saveToFile();
+        string fileText;
+        {
+            ifstream in(filename, ios::binary);
+            fileText.assign((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        }
+        size_t lead = fileText.find('\xD0');
+        if (lead != string::npos) fileText.erase(lead, 1);
+        {
+            ofstream out(filename, ios::binary | ios::trunc);
+            out << fileText;
+        }
+        notes.clear();
+        loadFromFile();
+        bool guessKept = lead != string::npos && getFileEncoding() == TextEncoding::Utf8 &&
+            notes.size() == cp1251Notes.size();
+        notes = cp1251Notes;
+        rebuildIndexes();
+
+        cout << (cp1251Detected ? "CP-1251" : "-") << ", " << (utf8Detected ? "UTF-8" : "-") << ", "
+            << (samples ? "образцы" : "-") << ", " << (guessKept ? "догадка" : "-") << endl;
+        if (cp1251Detected && utf8Detected && samples && guessKept) cout << "   + ТЕСТ ПРОЙДЕН" << endl;
+        else cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+    }
+    catch (const exception& e) {
+        cout << "ошибка: " << e.what() << endl;
+        cout << "   ! ТЕСТ НЕ ПРОЙДЕН" << endl;
+    }
+    setFileEncoding(TextEncoding::Cp1251);
+    journal.detach();
+    std::remove("test_notes_detect.txt");
+    std::remove("test_notes_detect.txt.journal");
+
     // Восстанавливаем оригинальное имя файла
     filename = originalFileName;
 
@@ -678,6 +1629,8 @@ void Notebook::runTestScenarios() {
     // 8. ВОССТАНОВЛЕНИЕ ОРИГИНАЛЬНЫХ ДАННЫХ
     cout << "\n8. Восстановление оригинальных данных..." << endl;
     notes = originalNotes;
+    rebuildIndexes();
+    journal.detach();  // Следующее сохранение запишет полный снимок
     cout << "   + Восстановлено " << notes.size() << " оригинальных заметок" << endl;
 
     // 9. ИТОГИ ТЕСТИРОВАНИЯ
@@ -2,44 +2,110 @@
 #pragma once
 
 #include "Note.h"
+#include "NoteSerializer.h"
+#include "NoteJournal.h"
+#include "WordIndex.h"
+#include "TrigramIndex.h"
+#include "TagIndex.h"
+#include "TimeIndex.h"
+#include "SlotRanks.h"
+#include "NoteStats.h"
+#include "EncodingUtils.h"
 #include <vector>    //    
 #include <map>       //  
+#include <unordered_map>
 #include <string>
+#include <istream>
 #include <algorithm>
 
+//    
+enum class WordMatch {
+    Substring,  //      ( )
+    WholeWord   //     
+};
+
+//    
+enum class TagMatch {
+    Substring,  //   
+    Exact       //     (  )
+};
+
 //  Notebook    -  
 //    , ,     
 class Notebook {
 private:
     //   -  
     std::vector<Note> notes;      //      (STL vector)
+                                  //         0
     std::string filename = "notes.json";  //    /
+    StorageFormat storageFormat = StorageFormat::Text;  // ,    
+    TextEncoding textEncoding = TextEncoding::Cp1251;   //     
+    TextEncoding fileEncoding = TextEncoding::Cp1251;   //   
+    bool encodingDetection = true;  //      
+    NoteJournal journal;          //     
+    uint64_t snapshotGeneration = 0;  //      
+    size_t checkpointInterval = 1000;  //   ,     
+    WordIndex wordIndex;          //      
+    TrigramIndex trigramIndex;    //       
+    TagIndex tagIndex;            //     
+    TimeIndex timeIndex;          // ,    
+    NoteStats stats;              //     
+    NoteId nextId = 1;            //     
+    std::unordered_map<NoteId, size_t> slotById;  //  ->   notes
+    SlotRanks deadSlots;               //   notes     
+    std::vector<NoteId> removedIds;    //  ,      
+    double compactionRatio = 0.25;     //  ,   notes 
+    size_t parallelScanThreshold = 50000;  //  notes,      
 
 public:
     // ========== CRUD  (   ) ==========
 
-    //      
-    void addNote(const Note& note);
+    //      ,    
+    NoteId addNote(const Note& note);
 
     //    ,   
+    //     O(1);    
     bool removeNote(int index);
 
-    //       ( )
-    Note* getNote(int index);
+    //       ( ;  -  updateNote)
+    const Note* getNote(int index) const;
 
     //   ,   
+    //   ,  updatedNote 
     bool updateNote(int index, const Note& updatedNote);
 
+    // ==========    ==========
+    //       , 
+    //         
+
+    const Note* getNoteById(NoteId id) const;
+    bool updateNoteById(NoteId id, const Note& updatedNote);
+    bool removeNoteById(NoteId id);
+
+    //      id  -1,   
+    int indexOf(NoteId id) const;
+
     // ==========    ==========
 
     //      ( )
     std::vector<int> findByAuthor(const std::string& author) const;
 
-    //      
-    std::vector<int> findByTag(const std::string& tag) const;
+    //       (  )
+    std::vector<int> findByTag(const std::string& tag, TagMatch mode = TagMatch::Substring) const;
+
+    //      all,     any ( )    none
+    //      ;     
+    std::vector<int> findByTags(const std::vector<std::string>& all, const std::vector<std::string>& any = {},
+        const std::vector<std::string>& none = {}) const;
 
     //   ,    ()
-    std::vector<int> findByWord(const std::string& word) const;
+    //          
+    // WholeWord    ,     
+    std::vector<int> findByWord(const std::string& word, WordMatch mode = WordMatch::Substring) const;
+
+    // k       (BM25    ),
+    //  ;       
+    std::vector<int> findTopByWord(const std::string& query, size_t k) const;
 
     //   ,      
     std::vector<int> findByDate(const std::string& date) const;
@@ -47,26 +113,76 @@ public:
     //   ,    N 
     std::vector<int> findByLastNDays(int days) const;
 
+    //   ,  -    
+    std::vector<NoteId> findIdsByAuthor(const std::string& author) const;
+    std::vector<NoteId> findIdsByTag(const std::string& tag, TagMatch mode = TagMatch::Substring) const;
+    std::vector<NoteId> findIdsByTags(const std::vector<std::string>& all, const std::vector<std::string>& any = {},
+        const std::vector<std::string>& none = {}) const;
+    std::vector<NoteId> findIdsByWord(const std::string& word, WordMatch mode = WordMatch::Substring) const;
+    std::vector<NoteId> findIdsByDate(const std::string& date) const;
+    std::vector<NoteId> findIdsByLastNDays(int days) const;
+    std::vector<ScoredNote> findTopIdsByWord(const std::string& query, size_t k) const;
+
     // ==========  ==========
 
     //    :  ->  
-    std::map<std::string, int> getAuthorStats() const;
+    //    ,    
+    const std::map<std::string, int>& getAuthorStats() const { return stats.getAuthorStats(); }
 
     //    :  ->  
-    std::map<std::string, int> getTagStats() const;
+    const std::map<std::string, int>& getTagStats() const { return stats.getTagStats(); }
 
     // ==========   ==========
 
-    //      (JSON )
+    //  :   ,  ,   
     void saveToFile();
 
-    //    
+    //  :         
+    void checkpoint();
+
+    //     (   )   
     void loadFromFile();
 
+    // ,         
+    void setCheckpointInterval(size_t records) { checkpointInterval = records; }
+
+    //  ,     
+    void setStorageFormat(StorageFormat format) { storageFormat = format; }
+    StorageFormat getStorageFormat() const { return storageFormat; }
+
+    //   :       
+    //       .      
+    //    (      ),   .
+    void setFileEncoding(TextEncoding encoding) { fileEncoding = encoding; }
+    TextEncoding getFileEncoding() const { return fileEncoding; }
+
+    //    :    ,   
+    // (EncodingUtils::detect_encoding).     fileEncoding,
+    //         ;  (   ASCII,
+    //    )    
+    void setEncodingDetection(bool enabled) { encodingDetection = enabled; }
+    bool getEncodingDetection() const { return encodingDetection; }
+
+    //     ;      .
+    //         ,   
+    //    (   )
+    void setTextEncoding(TextEncoding encoding);
+    TextEncoding getTextEncoding() const { return textEncoding; }
+
     // ==========  ==========
 
     //      
-    int getNoteCount() const { return (int)notes.size(); }
+    int getNoteCount() const { return (int)(notes.size() - deadSlots.deadCount()); }
+
+    //  :        
+    void compact();
+
+    //   ,     
+    void setCompactionRatio(double ratio) { compactionRatio = ratio; }
+
+    //    ,        
+    //  ;     
+    void setParallelScanThreshold(size_t noteCount) { parallelScanThreshold = noteCount; }
 
     //     ( )
     void printAll() const;
@@ -83,7 +199,47 @@ public:
 private:
     // ==========   ==========
 
-    //      (  )
-    static std::string toLower(const std::string& str);
+    //         
+    std::string toLower(const std::string& str) const;
+
+    //       (, )
+    void rebuildIndexes();
+
+    //       ,    ( ,
+    //      );      
+    EncodingGuess detectFileEncoding(std::istream& file, size_t size) const;
+
+    //      (  )   slotById
+    //  true,        
+    bool assignIds();
+
+    //       (  )
+    std::vector<int> toIndices(const std::vector<NoteId>& ids) const;
+    std::vector<NoteId> toIds(const std::vector<int>& indices) const;
+
+    //     ,    
+    std::vector<NoteId> liveOnly(std::vector<NoteId> ids) const;
+
+    //   (   ):     ,
+    // false -    ;       
+    bool findWordByTrigrams(const std::string& searchWord, std::vector<NoteId>& result) const;
+    std::vector<int> scanWord(const std::string& searchWord) const;
+
+    //  :   ,   matches(note) ,  
+    //      notes    
+    template <typename Predicate>
+    std::vector<int> scanNotes(Predicate matches) const;
+
+    //  (    ) <->   notes
+    size_t slotOf(int index) const;
+    int indexOfSlot(size_t slot) const;
+
+    //        notes
+    void updateSlot(size_t slot, const Note& updatedNote);
+    void removeSlot(size_t slot);
+
+    //  :    notes;     
+    void compactSlots();
+    void purgeIndexes();
 
 };
\ No newline at end of file
@@ -0,0 +1,53 @@
+// Parallel.h
+#pragma once
+
+#include "ThreadPool.h"
+#include <thread>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <cstddef>
+
+namespace Parallel {
+
+    //      ( ,  1)
+    inline unsigned workerCount() {
+        unsigned count = std::thread::hardware_concurrency();
+        return count == 0 ? 1 : count;
+    }
+
+    //  body(i)  i  [0, taskCount)     workers 
+    //     ;    .
+    //       ThreadPool -    
+    template <typename Body>
+    void forEachTask(size_t taskCount, Body body, unsigned workers = workerCount()) {
+        if (taskCount == 0) return;
+        if (workers > taskCount) workers = (unsigned)taskCount;
+
+        if (workers <= 1) {
+            for (size_t i = 0; i < taskCount; ++i) body(i);
+            return;
+        }
+
+        std::atomic<size_t> next(0);
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        std::function<void()> worker = [&]() {
+            for (size_t i = next++; i < taskCount; i = next++) {
+                try {
+                    body(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                }
+            }
+        };
+        ThreadPool::shared().run(workers - 1, worker);
+
+        if (error) std::rethrow_exception(error);
+    }
+
+} // namespace Parallel
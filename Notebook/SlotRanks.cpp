@@ -0,0 +1,69 @@
+﻿#include "SlotRanks.h"
+
+// ========== ОБНОВЛЕНИЕ ==========
+
+void SlotRanks::reset(size_t count) {
+    dead.assign(count, false);
+    // Все позиции живые: узел i покрывает (i - lowbit(i), i] и равен своей длине
+    tree.assign(count + 1, 0);
+    for (size_t i = 1; i <= count; ++i) {
+        tree[i] = i & (0 - i);
+    }
+    deadTotal = 0;
+}
+
+void SlotRanks::append() {
+    dead.push_back(false);
+    size_t i = dead.size();
+    // Новый узел i покрывает (i - lowbit(i), i]: сумму собираем из уже готовых узлов
+    tree.resize(i + 1);
+    tree[i] = 1 + prefix(i - 1) - prefix(i - (i & (0 - i)));
+}
+
+void SlotRanks::kill(size_t slot) {
+    if (slot >= dead.size() || dead[slot]) {
+        return;
+    }
+    dead[slot] = true;
+    ++deadTotal;
+    for (size_t i = slot + 1; i < tree.size(); i += i & (0 - i)) {
+        --tree[i];
+    }
+}
+
+// ========== ПОЗИЦИИ И ИНДЕКСЫ ==========
+
+size_t SlotRanks::prefix(size_t count) const {
+    size_t sum = 0;
+    for (size_t i = count; i > 0; i -= i & (0 - i)) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+size_t SlotRanks::rankOf(size_t slot) const {
+    if (deadTotal == 0) {
+        return slot;
+    }
+    return prefix(slot);
+}
+
+size_t SlotRanks::select(size_t index) const {
+    if (deadTotal == 0) {
+        return index;
+    }
+    // Спуск по дереву: наибольшая позиция pos, перед которой не больше index живых
+    size_t n = dead.size();
+    size_t step = 1;
+    while (step * 2 <= n) step *= 2;
+
+    size_t pos = 0;
+    size_t remaining = index;
+    for (; step > 0; step /= 2) {
+        if (pos + step <= n && tree[pos + step] <= remaining) {
+            pos += step;
+            remaining -= tree[pos];
+        }
+    }
+    return pos;
+}
@@ -0,0 +1,41 @@
+// SlotRanks.h
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+//  SlotRanks -         
+//           :
+// ,       <->   
+//   O(log n)     .
+class SlotRanks {
+public:
+    //  count   (   )
+    void reset(size_t count);
+
+    //     
+    void append();
+
+    //   ;     
+    void kill(size_t slot);
+
+    //   
+    bool isDead(size_t slot) const { return slot < dead.size() && dead[slot]; }
+
+    //  
+    size_t deadCount() const { return deadTotal; }
+
+    //     slot -     
+    size_t rankOf(size_t slot) const;
+
+    //      index (index   )
+    size_t select(size_t index) const;
+
+private:
+    std::vector<bool> dead;       //    
+    std::vector<size_t> tree;     //      (  1)
+    size_t deadTotal = 0;         //    
+
+    //      count
+    size_t prefix(size_t count) const;
+};
@@ -0,0 +1,80 @@
+﻿#include "SymbolTable.h"
+#include "CaseFolding.h"
+#include <stdexcept>
+#include <limits>
+
+SymbolTable& SymbolTable::authors() {
+    static SymbolTable table;
+    return table;
+}
+
+SymbolTable& SymbolTable::tags() {
+    static SymbolTable table;
+    return table;
+}
+
+SymbolTable::SymbolTable() {
+    for (size_t chunk = 0; chunk < MAX_CHUNKS; ++chunk) {
+        chunks[chunk].store(nullptr, std::memory_order_relaxed);
+        foldedChunks[chunk].store(nullptr, std::memory_order_relaxed);
+    }
+    intern(std::string_view());  // EMPTY
+}
+
+SymbolTable::~SymbolTable() {
+    for (size_t chunk = 0; chunk < MAX_CHUNKS; ++chunk) {
+        delete[] chunks[chunk].load(std::memory_order_relaxed);
+        delete[] foldedChunks[chunk].load(std::memory_order_relaxed);
+    }
+}
+
+SymbolId SymbolTable::intern(std::string_view name) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = idByName.find(name);
+    if (found != idByName.end()) {
+        return found->second;
+    }
+
+    size_t id = count.load(std::memory_order_relaxed);
+    if (id > (std::numeric_limits<SymbolId>::max)()) {
+        throw std::runtime_error("Symbol table overflow");
+    }
+
+    // Новый блок создаётся до публикации идентификатора, прежние блоки не перемещаются
+    size_t chunk = chunkOf((SymbolId)id);
+    std::string* block = chunks[chunk].load(std::memory_order_relaxed);
+    if (!block) {
+        block = new std::string[FIRST_CHUNK_SIZE << chunk];
+        chunks[chunk].store(block, std::memory_order_release);
+    }
+
+    std::string& stored = block[id - chunkStart(chunk)];
+    stored.assign(name.data(), name.size());
+    idByName.emplace(std::string_view(stored), (SymbolId)id);
+    count.store(id + 1, std::memory_order_release);
+    return (SymbolId)id;
+}
+
+size_t SymbolTable::foldUtf8() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t total = count.load(std::memory_order_relaxed);
+    for (size_t id = foldedCount.load(std::memory_order_relaxed); id < total; ++id) {
+        size_t chunk = chunkOf((SymbolId)id);
+        std::string* block = foldedChunks[chunk].load(std::memory_order_relaxed);
+        if (!block) {
+            block = new std::string[FIRST_CHUNK_SIZE << chunk];
+            foldedChunks[chunk].store(block, std::memory_order_release);
+        }
+        block[id - chunkStart(chunk)] = CaseFolding::toLowerUtf8(name((SymbolId)id));
+    }
+    foldedCount.store(total, std::memory_order_release);
+    return total;
+}
+
+int64_t SymbolTable::find(std::string_view name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = idByName.find(name);
+    return found == idByName.end() ? -1 : (int64_t)found->second;
+}
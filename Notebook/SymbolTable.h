@@ -0,0 +1,86 @@
+// SymbolTable.h
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// 32-     SymbolTable
+typedef uint32_t SymbolId;
+
+//  SymbolTable -     (, )
+//         32- ;
+//    ,     -  .
+//       ,    name()
+//  .  0    .
+//
+//   ,      : 
+//             
+//    . name()  :    
+//  ,    .
+class SymbolTable {
+public:
+    static const SymbolId EMPTY = 0;
+
+    //     
+    static SymbolTable& authors();
+    static SymbolTable& tags();
+
+    SymbolTable();
+    ~SymbolTable();
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    //  ;     
+    SymbolId intern(std::string_view name);
+
+    //    -1,     
+    int64_t find(std::string_view name) const;
+
+    //   
+    const std::string& name(SymbolId id) const {
+        size_t chunk = chunkOf(id);
+        return chunks[chunk].load(std::memory_order_acquire)[id - chunkStart(chunk)];
+    }
+
+    //     UTF-8 ,    
+    //      (  UTF-8)   ;
+    //   ,    foldedUtf8()
+    size_t foldUtf8() const;
+
+    //     (CaseFolding::toLowerUtf8); id   foldUtf8()
+    const std::string& foldedUtf8(SymbolId id) const {
+        size_t chunk = chunkOf(id);
+        return foldedChunks[chunk].load(std::memory_order_acquire)[id - chunkStart(chunk)];
+    }
+
+    //    ( -  0  size() - 1)
+    size_t size() const { return count.load(std::memory_order_acquire); }
+
+private:
+    //  k  FIRST_CHUNK_SIZE * 2^k ; 24     SymbolId
+    static const size_t FIRST_CHUNK_SIZE = 256;
+    static const size_t MAX_CHUNKS = 24;
+
+    std::atomic<std::string*> chunks[MAX_CHUNKS];
+    mutable std::atomic<std::string*> foldedChunks[MAX_CHUNKS];  //   foldUtf8()
+    std::atomic<size_t> count{ 0 };
+    mutable std::atomic<size_t> foldedCount{ 0 };
+    std::unordered_map<std::string_view, SymbolId> idByName;  //     
+    mutable std::mutex mutex;
+
+    static size_t chunkOf(SymbolId id) {
+        size_t n = id / FIRST_CHUNK_SIZE + 1;
+        size_t chunk = 0;
+        while (n >>= 1) ++chunk;
+        return chunk;
+    }
+
+    static size_t chunkStart(size_t chunk) {
+        return FIRST_CHUNK_SIZE * (((size_t)1 << chunk) - 1);
+    }
+};
@@ -0,0 +1,183 @@
+﻿#include "TagIndex.h"
+#include "CaseFolding.h"
+#include <algorithm>
+#include <iterator>
+
+// ========== ОБНОВЛЕНИЕ ИНДЕКСА ==========
+
+void TagIndex::rebuild(const std::vector<Note>& notes) {
+    tags.clear();
+    idsByFolded.clear();
+    for (const auto& note : notes) {
+        add(note);
+    }
+}
+
+TagIndex::TagEntry& TagIndex::entryFor(SymbolId tag) {
+    if (tag >= tags.size()) {
+        tags.resize((size_t)tag + 1);
+    }
+
+    TagEntry& entry = tags[tag];
+    if (!entry.known) {
+        entry.known = true;
+        entry.folded = CaseFolding::toLower(SymbolTable::tags().name(tag), encoding);
+        idsByFolded[entry.folded].push_back(tag);
+    }
+    return entry;
+}
+
+void TagIndex::add(const Note& note) {
+    NoteId id = note.getId();
+    for (SymbolId tag : note.getTagIds()) {
+        TagEntry& entry = entryFor(tag);
+
+        // Повтор тега внутри заметки не дублирует её в списке
+        auto& list = entry.notes;
+        if (list.empty() || list.back() < id) {
+            list.push_back(id);
+        }
+        else {
+            auto it = std::lower_bound(list.begin(), list.end(), id);
+            if (it == list.end() || *it != id) list.insert(it, id);
+        }
+    }
+}
+
+void TagIndex::unlink(const Note& note) {
+    NoteId id = note.getId();
+    for (SymbolId tag : note.getTagIds()) {
+        if (tag >= tags.size()) continue;
+
+        auto& list = tags[tag].notes;
+        auto it = std::lower_bound(list.begin(), list.end(), id);
+        if (it != list.end() && *it == id) list.erase(it);
+    }
+}
+
+void TagIndex::update(const Note& oldNote, const Note& newNote) {
+    unlink(oldNote);
+    add(newNote);
+}
+
+void TagIndex::remove(const Note& note) {
+    unlink(note);
+}
+
+void TagIndex::purge(const std::function<bool(NoteId)>& isRemoved) {
+    for (auto& entry : tags) {
+        auto& list = entry.notes;
+        list.erase(std::remove_if(list.begin(), list.end(), isRemoved), list.end());
+    }
+}
+
+// ========== ПОИСК ==========
+
+std::vector<NoteId> TagIndex::collect(const std::vector<SymbolId>& tagIds) const {
+    if (tagIds.size() == 1) {
+        return tags[tagIds[0]].notes;
+    }
+
+    std::vector<NoteId> result;
+    for (SymbolId id : tagIds) {
+        result.insert(result.end(), tags[id].notes.begin(), tags[id].notes.end());
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+std::vector<NoteId> TagIndex::findExact(const std::string& tag) const {
+    auto found = idsByFolded.find(CaseFolding::toLower(tag, encoding));
+    if (found == idsByFolded.end()) {
+        return std::vector<NoteId>();
+    }
+    return collect(found->second);
+}
+
+std::vector<NoteId> TagIndex::findContaining(const std::string& part) const {
+    std::string folded = CaseFolding::toLower(part, encoding);
+
+    std::vector<SymbolId> matching;
+    for (size_t id = 0; id < tags.size(); ++id) {
+        if (!tags[id].notes.empty() && tags[id].folded.find(folded) != std::string::npos) {
+            matching.push_back((SymbolId)id);
+        }
+    }
+    return matching.empty() ? std::vector<NoteId>() : collect(matching);
+}
+
+std::vector<NoteId> TagIndex::findByTags(const std::vector<std::string>& all, const std::vector<std::string>& any,
+    const std::vector<std::string>& none, const std::vector<NoteId>& universe) const {
+    // Каждый обязательный тег - свой список; неизвестный тег сразу даёт пустой результат
+    std::vector<std::vector<NoteId>> required;
+    required.reserve(all.size() + 1);
+    for (const auto& tag : all) {
+        required.push_back(findExact(tag));
+        if (required.back().empty()) return std::vector<NoteId>();
+    }
+    if (!any.empty()) {
+        std::vector<NoteId> anyNotes;
+        for (const auto& tag : any) {
+            std::vector<NoteId> notes = findExact(tag);
+            anyNotes.insert(anyNotes.end(), notes.begin(), notes.end());
+        }
+        std::sort(anyNotes.begin(), anyNotes.end());
+        anyNotes.erase(std::unique(anyNotes.begin(), anyNotes.end()), anyNotes.end());
+        if (anyNotes.empty()) return anyNotes;
+        required.push_back(std::move(anyNotes));
+    }
+
+    // Пересечение от самого короткого списка: размер результата не больше его длины
+    std::vector<NoteId> result;
+    if (required.empty()) {
+        result = universe;
+    }
+    else {
+        std::sort(required.begin(), required.end(),
+            [](const std::vector<NoteId>& a, const std::vector<NoteId>& b) { return a.size() < b.size(); });
+        result = std::move(required[0]);
+        for (size_t i = 1; i < required.size() && !result.empty(); ++i) {
+            result = intersect(result, required[i]);
+        }
+    }
+
+    for (const auto& tag : none) {
+        if (result.empty()) break;
+        result = subtract(result, findExact(tag));
+    }
+    return result;
+}
+
+std::vector<NoteId> TagIndex::intersect(const std::vector<NoteId>& shorter, const std::vector<NoteId>& longer) {
+    std::vector<NoteId> result;
+    result.reserve(shorter.size());
+
+    // При большой разнице длин дешевле искать каждый элемент двоичным поиском
+    if (shorter.size() * 16 < longer.size()) {
+        auto from = longer.begin();
+        for (NoteId id : shorter) {
+            from = std::lower_bound(from, longer.end(), id);
+            if (from == longer.end()) break;
+            if (*from == id) result.push_back(id);
+        }
+        return result;
+    }
+
+    std::set_intersection(shorter.begin(), shorter.end(), longer.begin(), longer.end(), std::back_inserter(result));
+    return result;
+}
+
+std::vector<NoteId> TagIndex::subtract(const std::vector<NoteId>& from, const std::vector<NoteId>& removed) {
+    if (removed.empty()) return from;
+
+    std::vector<NoteId> result;
+    result.reserve(from.size());
+    std::set_difference(from.begin(), from.end(), removed.begin(), removed.end(), std::back_inserter(result));
+    return result;
+}
+
+int64_t TagIndex::getTagId(const std::string& tag) const {
+    int64_t id = SymbolTable::tags().find(tag);
+    return id >= 0 && (size_t)id < tags.size() && tags[(size_t)id].known ? id : -1;
+}
@@ -0,0 +1,75 @@
+// TagIndex.h
+#pragma once
+
+#include "Note.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+
+//  TagIndex -     
+//     SymbolTable::tags();   
+//     .  
+//     ,     
+//  O().
+class TagIndex {
+public:
+    //      
+    void rebuild(const std::vector<Note>& notes);
+
+    //   ( -  )
+    void add(const Note& note);
+
+    //        
+    void update(const Note& oldNote, const Note& newNote);
+
+    //  ;     
+    void remove(const Note& note);
+
+    //    ,  
+    //          -   Notebook
+    void purge(const std::function<bool(NoteId)>& isRemoved);
+
+    //   ,      
+    std::vector<NoteId> findExact(const std::string& tag) const;
+
+    //   ,       
+    //    ,    
+    std::vector<NoteId> findContaining(const std::string& part) const;
+
+    // ,      all,     any ( any  )
+    //     none;      .
+    //        ,
+    //    .  all  any ,    universe
+    // (      ).
+    std::vector<NoteId> findByTags(const std::vector<std::string>& all, const std::vector<std::string>& any,
+        const std::vector<std::string>& none, const std::vector<NoteId>& universe) const;
+
+    //    -1,        
+    int64_t getTagId(const std::string& tag) const;
+
+    //  ;      (rebuild)
+    void setEncoding(TextEncoding newEncoding) { encoding = newEncoding; }
+
+private:
+    struct TagEntry {
+        bool known = false;      //    
+        std::string folded;      //    
+        std::vector<NoteId> notes;  //    
+    };
+
+    std::vector<TagEntry> tags;                                         //  -> 
+    std::unordered_map<std::string, std::vector<SymbolId>> idsByFolded;  //     -> 
+    TextEncoding encoding = TextEncoding::Cp1251;
+
+    TagEntry& entryFor(SymbolId tag);
+    void unlink(const Note& note);
+
+    //     
+    std::vector<NoteId> collect(const std::vector<SymbolId>& tagIds) const;
+
+    //     
+    static std::vector<NoteId> intersect(const std::vector<NoteId>& shorter, const std::vector<NoteId>& longer);
+    static std::vector<NoteId> subtract(const std::vector<NoteId>& from, const std::vector<NoteId>& removed);
+};
@@ -0,0 +1,92 @@
+﻿#include "ThreadPool.h"
+#include "Parallel.h"
+#include <memory>
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(Parallel::workerCount() - 1);
+    return pool;
+}
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    threads.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) return;  // stopping и заданий не осталось
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
+
+// ========== ВЫПОЛНЕНИЕ ==========
+
+namespace {
+
+    // Состояние одного вызова run: задания в очереди могут пережить вызов,
+    // поэтому оно разделяется между ними и вызывающим потоком
+    struct Batch {
+        std::mutex mutex;
+        std::condition_variable idle;
+        const std::function<void()>* work = nullptr;
+        unsigned active = 0;   // Потоки пула, выполняющие work
+        bool closed = false;   // Вызывающий поток закончил - новые потоки не начинают
+    };
+
+} // namespace
+
+void ThreadPool::run(unsigned helpers, const std::function<void()>& work) {
+    if (helpers > size()) helpers = size();
+    if (helpers == 0) {
+        work();
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->work = &work;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (unsigned i = 0; i < helpers; ++i) {
+            queue.push_back([batch]() {
+                {
+                    std::lock_guard<std::mutex> batchLock(batch->mutex);
+                    if (batch->closed) return;
+                    ++batch->active;
+                }
+                (*batch->work)();
+                {
+                    std::lock_guard<std::mutex> batchLock(batch->mutex);
+                    --batch->active;
+                }
+                batch->idle.notify_all();
+            });
+        }
+    }
+    wake.notify_all();
+
+    work();  // Текущий поток тоже участвует в работе
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->closed = true;
+    batch->idle.wait(lock, [&]() { return batch->active == 0; });
+}
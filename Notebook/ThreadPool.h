@@ -0,0 +1,43 @@
+// ThreadPool.h
+#pragma once
+
+#include <thread>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+//  ThreadPool -      
+//       ,  ,   ,
+//       .   (shared())  
+//        ,  :  
+//    .
+class ThreadPool {
+public:
+    //   
+    static ThreadPool& shared();
+
+    explicit ThreadPool(unsigned threadCount);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return (unsigned)threads.size(); }
+
+    //  work         helpers  ;  -
+    //  ,    work  .  ,  
+    //    work   ,    , 
+    //         . work   
+    //  (Parallel::forEachTask   )
+    void run(unsigned helpers, const std::function<void()>& work);
+
+private:
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> queue;  // ,    
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop();
+};
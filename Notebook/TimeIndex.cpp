@@ -0,0 +1,67 @@
+﻿#include "TimeIndex.h"
+#include <algorithm>
+
+// ========== ОБНОВЛЕНИЕ ИНДЕКСА ==========
+
+void TimeIndex::rebuild(const std::vector<Note>& notes) {
+    byCreated.clear();
+    byCreated.reserve(notes.size());
+    for (const auto& note : notes) {
+        byCreated.emplace_back(note.getCreatedTime(), note.getId());
+    }
+    std::sort(byCreated.begin(), byCreated.end());
+}
+
+void TimeIndex::add(const Note& note) {
+    auto entry = std::make_pair(note.getCreatedTime(), note.getId());
+    // Новые заметки обычно самые поздние - добавляем в конец без сдвига
+    if (byCreated.empty() || byCreated.back() < entry) {
+        byCreated.push_back(entry);
+    }
+    else {
+        byCreated.insert(std::lower_bound(byCreated.begin(), byCreated.end(), entry), entry);
+    }
+}
+
+void TimeIndex::update(const Note& oldNote, const Note& newNote) {
+    if (oldNote.getCreatedTime() == newNote.getCreatedTime()) {
+        return;  // Порядок не изменился
+    }
+    remove(oldNote);
+    add(newNote);
+}
+
+void TimeIndex::remove(const Note& note) {
+    auto entry = std::make_pair(note.getCreatedTime(), note.getId());
+    auto it = std::lower_bound(byCreated.begin(), byCreated.end(), entry);
+    if (it != byCreated.end() && *it == entry) {
+        byCreated.erase(it);
+    }
+}
+
+void TimeIndex::purge(const std::function<bool(NoteId)>& isRemoved) {
+    byCreated.erase(std::remove_if(byCreated.begin(), byCreated.end(),
+        [&](const std::pair<time_t, NoteId>& entry) { return isRemoved(entry.second); }),
+        byCreated.end());
+}
+
+// ========== ПОИСК ==========
+
+std::vector<NoteId> TimeIndex::findCreatedBetween(time_t from, time_t to) const {
+    std::vector<NoteId> result;
+    if (from >= to) return result;
+
+    auto first = std::lower_bound(byCreated.begin(), byCreated.end(), from,
+        [](const std::pair<time_t, NoteId>& entry, time_t value) { return entry.first < value; });
+    auto last = std::lower_bound(first, byCreated.end(), to,
+        [](const std::pair<time_t, NoteId>& entry, time_t value) { return entry.first < value; });
+
+    result.reserve(last - first);
+    for (auto it = first; it != last; ++it) {
+        result.push_back(it->second);
+    }
+
+    // Результаты выдаются по возрастанию идентификаторов, как у других индексов
+    std::sort(result.begin(), result.end());
+    return result;
+}
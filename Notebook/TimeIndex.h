@@ -0,0 +1,37 @@
+// TimeIndex.h
+#pragma once
+
+#include "Note.h"
+#include <vector>
+#include <functional>
+#include <utility>
+#include <ctime>
+
+//  TimeIndex - ,    
+//    ( ,  ), 
+//       N  -    
+//        .
+class TimeIndex {
+public:
+    //      
+    void rebuild(const std::vector<Note>& notes);
+
+    //   ( -  )
+    void add(const Note& note);
+
+    //        
+    void update(const Note& oldNote, const Note& newNote);
+
+    //  ;     
+    void remove(const Note& note);
+
+    //    ,  
+    //          -   Notebook
+    void purge(const std::function<bool(NoteId)>& isRemoved);
+
+    // ,    [from, to) (  )
+    std::vector<NoteId> findCreatedBetween(time_t from, time_t to) const;
+
+private:
+    std::vector<std::pair<time_t, NoteId>> byCreated;  // ( , )  
+};
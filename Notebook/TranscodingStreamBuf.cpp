@@ -0,0 +1,95 @@
+﻿#include "TranscodingStreamBuf.h"
+#include <cstring>
+
+TranscodingStreamBuf::TranscodingStreamBuf(std::streambuf* target, TextEncoding from, TextEncoding to)
+    : target(target), from(from), to(to) {
+}
+
+TranscodingStreamBuf::~TranscodingStreamBuf() {
+    // Ошибку записи здесь уже некому сообщить - вызывающий проверяет результат finish()
+    if (pbase() != nullptr) {
+        flushOutput(true);
+    }
+}
+
+size_t TranscodingStreamBuf::completePrefix(const char* data, size_t size) const {
+    return from == TextEncoding::Utf8 ? EncodingUtils::utf8_complete_prefix(data, size) : size;
+}
+
+// ========== ЗАПИСЬ ==========
+
+bool TranscodingStreamBuf::flushOutput(bool final) {
+    if (output.empty()) {
+        // Первая запись: буферы создаются только у пишущего потока
+        output.resize(CHUNK_SIZE);
+        encoded.resize(EncodingUtils::max_transcoded_size(from, to, CHUNK_SIZE));
+        setp(output.data(), output.data() + output.size());
+        return true;
+    }
+
+    size_t pending = (size_t)(pptr() - pbase());
+    size_t complete = final ? pending : completePrefix(pbase(), pending);
+    size_t produced = EncodingUtils::transcode(from, to, pbase(), complete, encoded.data());
+    if ((size_t)target->sputn(encoded.data(), (std::streamsize)produced) != produced) {
+        return false;
+    }
+
+    // Оборванный символ переносится в начало буфера
+    size_t tail = pending - complete;
+    std::memmove(output.data(), output.data() + complete, tail);
+    setp(output.data(), output.data() + output.size());
+    pbump((int)tail);
+    return true;
+}
+
+TranscodingStreamBuf::int_type TranscodingStreamBuf::overflow(int_type ch) {
+    if (!flushOutput(false)) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int TranscodingStreamBuf::sync() {
+    if (pbase() == nullptr) return 0;
+    return flushOutput(false) ? 0 : -1;
+}
+
+bool TranscodingStreamBuf::finish() {
+    if (pbase() == nullptr) return true;
+    return flushOutput(true);
+}
+
+// ========== ЧТЕНИЕ ==========
+
+TranscodingStreamBuf::int_type TranscodingStreamBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    if (raw.empty()) {
+        raw.resize(CHUNK_SIZE);
+        decoded.resize(EncodingUtils::max_transcoded_size(from, to, CHUNK_SIZE));
+    }
+
+    size_t produced = 0;
+    while (produced == 0) {
+        // Кусок читается после перенесённого начала символа
+        size_t got = (size_t)target->sgetn(raw.data() + rawCarry, (std::streamsize)(raw.size() - rawCarry));
+        size_t available = rawCarry + got;
+        if (available == 0) {
+            return traits_type::eof();
+        }
+
+        // В конце данных оборванный символ перекодируется как есть (заменится на '?')
+        size_t complete = got == 0 ? available : completePrefix(raw.data(), available);
+        produced = EncodingUtils::transcode(from, to, raw.data(), complete, decoded.data());
+
+        rawCarry = available - complete;
+        std::memmove(raw.data(), raw.data() + complete, rawCarry);
+    }
+    setg(decoded.data(), decoded.data(), decoded.data() + produced);
+    return traits_type::to_int_type(*gptr());
+}
@@ -0,0 +1,50 @@
+// TranscodingStreamBuf.h
+#pragma once
+
+#include "EncodingUtils.h"
+#include <streambuf>
+#include <vector>
+#include <cstddef>
+
+//  TranscodingStreamBuf -  ,    
+// :    from        target   to.
+// :   target   from       to.
+//  UTF-8,   ,    , 
+//        ,    ,   .
+class TranscodingStreamBuf : public std::streambuf {
+public:
+    //    
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    TranscodingStreamBuf(std::streambuf* target, TextEncoding from, TextEncoding to);
+    ~TranscodingStreamBuf() override;
+
+    TranscodingStreamBuf(const TranscodingStreamBuf&) = delete;
+    TranscodingStreamBuf& operator=(const TranscodingStreamBuf&) = delete;
+
+    //   target   ,     
+    //  false,  target   
+    bool finish();
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+    int_type underflow() override;
+
+private:
+    std::streambuf* target;
+    TextEncoding from;
+    TextEncoding to;
+
+    std::vector<char> output;     // :   ( put)
+    std::vector<char> encoded;    // :    target
+    std::vector<char> raw;        // :    target
+    std::vector<char> decoded;    // :   ( get)
+    size_t rawCarry = 0;          // :      
+
+    //      target; final -    
+    bool flushOutput(bool final);
+
+    //       ( UTF-8  )
+    size_t completePrefix(const char* data, size_t size) const;
+};
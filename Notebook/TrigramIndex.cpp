@@ -0,0 +1,170 @@
+﻿#include "TrigramIndex.h"
+#include "CaseFolding.h"
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+
+// ========== РАЗБИЕНИЕ НА ТРИГРАММЫ ==========
+
+void TrigramIndex::appendTrigrams(std::string_view text, std::vector<uint32_t>& keys) const {
+    if (text.size() < MIN_QUERY_LENGTH) return;
+
+    // Регистр UTF-8 приводится по кодовым точкам, поэтому сначала - копия текста целиком
+    if (encoding == TextEncoding::Utf8) {
+        appendFoldedTrigrams(CaseFolding::toLowerUtf8(text), keys);
+        return;
+    }
+
+    // Скользящее окно: каждый символ приводится к нижнему регистру один раз
+    uint32_t key = ((uint32_t)(unsigned char)CaseFolding::foldCp1251(text[0]) << 8) |
+        (uint32_t)(unsigned char)CaseFolding::foldCp1251(text[1]);
+    for (size_t i = 2; i < text.size(); ++i) {
+        key = ((key << 8) | (uint32_t)(unsigned char)CaseFolding::foldCp1251(text[i])) & 0xFFFFFF;
+        keys.push_back(key);
+    }
+}
+
+void TrigramIndex::appendFoldedTrigrams(std::string_view folded, std::vector<uint32_t>& keys) {
+    if (folded.size() < MIN_QUERY_LENGTH) return;
+
+    uint32_t key = ((uint32_t)(unsigned char)folded[0] << 8) | (uint32_t)(unsigned char)folded[1];
+    for (size_t i = 2; i < folded.size(); ++i) {
+        key = ((key << 8) | (uint32_t)(unsigned char)folded[i]) & 0xFFFFFF;
+        keys.push_back(key);
+    }
+}
+
+std::vector<uint32_t> TrigramIndex::noteTrigrams(const Note& note) const {
+    std::vector<uint32_t> keys;
+    keys.reserve(note.getTitle().size() + note.getContent().size());
+    appendTrigrams(note.getTitle(), keys);
+    appendTrigrams(note.getContent(), keys);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+// ========== ОБНОВЛЕНИЕ ИНДЕКСА ==========
+
+void TrigramIndex::rebuild(const std::vector<Note>& notes) {
+    postings.clear();
+    for (const auto& note : notes) {
+        add(note);
+    }
+}
+
+void TrigramIndex::add(const Note& note) {
+    NoteId id = note.getId();
+    for (uint32_t key : noteTrigrams(note)) {
+        auto& list = postings[key];
+        // Новые заметки получают самый большой идентификатор - самый частый случай
+        if (list.empty() || list.back() < id) {
+            list.push_back(id);
+            continue;
+        }
+        auto it = std::lower_bound(list.begin(), list.end(), id);
+        if (it == list.end() || *it != id) list.insert(it, id);
+    }
+}
+
+void TrigramIndex::update(const Note& oldNote, const Note& newNote) {
+    erasePostings(oldNote);
+    add(newNote);
+}
+
+void TrigramIndex::remove(const Note& note) {
+    erasePostings(note);
+}
+
+void TrigramIndex::erasePostings(const Note& note) {
+    NoteId id = note.getId();
+    for (uint32_t key : noteTrigrams(note)) {
+        auto found = postings.find(key);
+        if (found == postings.end()) continue;
+
+        auto& list = found->second;
+        auto it = std::lower_bound(list.begin(), list.end(), id);
+        if (it != list.end() && *it == id) list.erase(it);
+        if (list.empty()) postings.erase(found);
+    }
+}
+
+void TrigramIndex::purge(const std::function<bool(NoteId)>& isRemoved) {
+    for (auto it = postings.begin(); it != postings.end();) {
+        auto& list = it->second;
+        list.erase(std::remove_if(list.begin(), list.end(), isRemoved), list.end());
+        it = list.empty() ? postings.erase(it) : std::next(it);
+    }
+}
+
+// ========== ПОИСК ==========
+
+std::vector<uint32_t> TrigramIndex::patternTrigrams(std::string_view foldedPattern) {
+    // Образец уже в нижнем регистре в кодировке индекса - приводить повторно нельзя:
+    // байты UTF-8 не являются символами CP-1251
+    std::vector<uint32_t> keys;
+    appendFoldedTrigrams(foldedPattern, keys);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+size_t TrigramIndex::estimate(std::string_view foldedPattern) const {
+    std::vector<uint32_t> keys = patternTrigrams(foldedPattern);
+    if (keys.empty()) {
+        return 0;
+    }
+
+    size_t shortest = SIZE_MAX;
+    for (uint32_t key : keys) {
+        auto found = postings.find(key);
+        if (found == postings.end()) return 0;
+        if (found->second.size() < shortest) shortest = found->second.size();
+    }
+    return shortest;
+}
+
+std::vector<NoteId> TrigramIndex::candidates(std::string_view foldedPattern) const {
+    std::vector<NoteId> result;
+    std::vector<uint32_t> keys = patternTrigrams(foldedPattern);
+
+    std::vector<const std::vector<NoteId>*> lists;
+    lists.reserve(keys.size());
+    for (uint32_t key : keys) {
+        auto found = postings.find(key);
+        if (found == postings.end()) {
+            return result;  // Триграммы нет ни в одной заметке
+        }
+        lists.push_back(&found->second);
+    }
+    if (lists.empty()) {
+        return result;
+    }
+
+    // Пересечение начинаем с самого короткого списка
+    std::sort(lists.begin(), lists.end(),
+        [](const std::vector<NoteId>* a, const std::vector<NoteId>* b) { return a->size() < b->size(); });
+
+    result = *lists[0];
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        const auto& longer = *lists[i];
+        std::vector<NoteId> intersection;
+        intersection.reserve(result.size());
+
+        // При большой разнице длин дешевле искать каждый элемент двоичным поиском
+        if (result.size() * 16 < longer.size()) {
+            auto from = longer.begin();
+            for (NoteId id : result) {
+                from = std::lower_bound(from, longer.end(), id);
+                if (from == longer.end()) break;
+                if (*from == id) intersection.push_back(id);
+            }
+        }
+        else {
+            std::set_intersection(result.begin(), result.end(),
+                longer.begin(), longer.end(), std::back_inserter(intersection));
+        }
+        result.swap(intersection);
+    }
+    return result;
+}
@@ -0,0 +1,67 @@
+// TrigramIndex.h
+#pragma once
+
+#include "Note.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+
+//  TrigramIndex -        
+//         
+//  ,   . ,  ,
+//     ,     - 
+// :      ,   .
+class TrigramIndex {
+public:
+    //      -   
+    static const size_t MIN_QUERY_LENGTH = 3;
+
+    //      
+    void rebuild(const std::vector<Note>& notes);
+
+    //   ( -  )
+    void add(const Note& note);
+
+    //        
+    void update(const Note& oldNote, const Note& newNote);
+
+    //  ;     
+    void remove(const Note& note);
+
+    //    ,  
+    //         -   Notebook
+    void purge(const std::function<bool(NoteId)>& isRemoved);
+
+    // ,     (   ,   MIN_QUERY_LENGTH)
+    //    :       
+    std::vector<NoteId> candidates(std::string_view foldedPattern) const;
+
+    //     -      
+    // ĸ:  ,  ,    
+    size_t estimate(std::string_view foldedPattern) const;
+
+    //   ;      (rebuild)
+    //  UTF-8    -      
+    void setEncoding(TextEncoding newEncoding) { encoding = newEncoding; }
+
+private:
+    std::unordered_map<uint32_t, std::vector<NoteId>> postings;
+    TextEncoding encoding = TextEncoding::Cp1251;
+
+    //    
+    static std::vector<uint32_t> patternTrigrams(std::string_view foldedPattern);
+
+    //      ( )
+    void appendTrigrams(std::string_view text, std::vector<uint32_t>& keys) const;
+
+    //  ,      ( )
+    static void appendFoldedTrigrams(std::string_view folded, std::vector<uint32_t>& keys);
+
+    //    ;   ,      
+    std::vector<uint32_t> noteTrigrams(const Note& note) const;
+
+    void erasePostings(const Note& note);
+};
@@ -0,0 +1,348 @@
+﻿#include "WordIndex.h"
+#include "CaseFolding.h"
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <limits>
+
+// ========== РАЗБИЕНИЕ НА СЛОВА ==========
+
+void WordIndex::appendTerms(std::string_view text, TextEncoding encoding, std::vector<std::string>& terms) {
+    if (encoding == TextEncoding::Utf8) {
+        appendTermsUtf8(text, terms);
+        return;
+    }
+
+    std::string current;
+
+    for (char c : text) {
+        if (CaseFolding::isWordCharCp1251(c)) {
+            current += CaseFolding::foldCp1251(c);
+        }
+        else if (!current.empty()) {
+            terms.push_back(current);
+            current.clear();
+        }
+    }
+    if (!current.empty()) {
+        terms.push_back(current);
+    }
+}
+
+void WordIndex::appendTermsUtf8(std::string_view text, std::vector<std::string>& terms) {
+    // Слово копируется целиком по границам символов и приводится к нижнему регистру на месте
+    size_t wordStart = std::string_view::npos;
+    for (size_t pos = 0; pos < text.size();) {
+        bool wordChar = false;
+        size_t length = CaseFolding::utf8Char(text, pos, wordChar);
+        if (wordChar) {
+            if (wordStart == std::string_view::npos) wordStart = pos;
+        }
+        else if (wordStart != std::string_view::npos) {
+            terms.emplace_back(text.substr(wordStart, pos - wordStart));
+            CaseFolding::foldUtf8(&terms.back()[0], terms.back().size());
+            wordStart = std::string_view::npos;
+        }
+        pos += length;
+    }
+    if (wordStart != std::string_view::npos) {
+        terms.emplace_back(text.substr(wordStart));
+        CaseFolding::foldUtf8(&terms.back()[0], terms.back().size());
+    }
+}
+
+void WordIndex::sortUnique(std::vector<std::string>& terms) {
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+}
+
+std::vector<std::string> WordIndex::tokenize(std::string_view text, TextEncoding encoding) {
+    std::vector<std::string> terms;
+    appendTerms(text, encoding, terms);
+    sortUnique(terms);
+    return terms;
+}
+
+std::vector<WordIndex::NoteTerm> WordIndex::noteTerms(const Note& note, FieldLengths& fieldLengths) const {
+    // Поиск по слову охватывает заголовок и содержимое; поля разбираются на месте, без склейки
+    std::vector<std::string> terms;
+    appendTerms(note.getTitle(), encoding, terms);
+    size_t titleEnd = terms.size();
+    appendTerms(note.getContent(), encoding, terms);
+    fieldLengths.title = (uint32_t)titleEnd;
+    fieldLengths.content = (uint32_t)(terms.size() - titleEnd);
+
+    // Повторы слова подряд после сортировки; поле вхождения - по исходной позиции
+    std::vector<uint32_t> order(terms.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = (uint32_t)i;
+    std::sort(order.begin(), order.end(),
+        [&](uint32_t a, uint32_t b) { return terms[a] < terms[b]; });
+
+    std::vector<NoteTerm> result;
+    for (size_t i = 0; i < order.size();) {
+        NoteTerm entry;
+        entry.term = std::move(terms[order[i]]);
+        size_t j = i;
+        for (; j < order.size() && (j == i || terms[order[j]] == entry.term); ++j) {
+            uint16_t& count = order[j] < titleEnd ? entry.counts.title : entry.counts.content;
+            if (count < UINT16_MAX) ++count;
+        }
+        entry.counts.titleLength = (uint16_t)(std::min)(fieldLengths.title, (uint32_t)UINT16_MAX);
+        entry.counts.contentLength = (uint16_t)(std::min)(fieldLengths.content, (uint32_t)UINT16_MAX);
+        result.push_back(std::move(entry));
+        i = j;
+    }
+    return result;
+}
+
+// ========== ОБНОВЛЕНИЕ ИНДЕКСА ==========
+
+void WordIndex::rebuild(const std::vector<Note>& notes) {
+    postings.clear();
+    lengths.clear();
+    titleWordTotal = 0;
+    contentWordTotal = 0;
+    for (const auto& note : notes) {
+        add(note);
+    }
+}
+
+void WordIndex::add(const Note& note) {
+    FieldLengths fieldLengths;
+    for (const auto& entry : noteTerms(note, fieldLengths)) {
+        insertPosting(entry.term, note.getId(), entry.counts);
+    }
+    addLengths(note.getId(), fieldLengths);
+}
+
+void WordIndex::update(const Note& oldNote, const Note& newNote) {
+    remove(oldNote);
+    add(newNote);
+}
+
+void WordIndex::remove(const Note& note) {
+    FieldLengths fieldLengths;
+    for (const auto& entry : noteTerms(note, fieldLengths)) {
+        erasePosting(entry.term, note.getId());
+    }
+    eraseLengths(note.getId());
+}
+
+void WordIndex::purge(const std::function<bool(NoteId)>& isRemoved) {
+    for (auto it = postings.begin(); it != postings.end();) {
+        auto& list = it->second;
+        // Идентификаторы и вхождения сдвигаются вместе
+        size_t kept = 0;
+        for (size_t i = 0; i < list.ids.size(); ++i) {
+            if (isRemoved(list.ids[i])) continue;
+            list.ids[kept] = list.ids[i];
+            list.counts[kept] = list.counts[i];
+            ++kept;
+        }
+        list.ids.resize(kept);
+        list.counts.resize(kept);
+        it = list.ids.empty() ? postings.erase(it) : std::next(it);
+    }
+
+    for (auto it = lengths.begin(); it != lengths.end();) {
+        if (isRemoved(it->first)) {
+            titleWordTotal -= it->second.title;
+            contentWordTotal -= it->second.content;
+            it = lengths.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void WordIndex::insertPosting(const std::string& term, NoteId id, TermCounts counts) {
+    auto& list = postings[term];
+    // Новые заметки получают самый большой идентификатор - самый частый случай
+    if (list.ids.empty() || list.ids.back() < id) {
+        list.ids.push_back(id);
+        list.counts.push_back(counts);
+        return;
+    }
+    auto it = std::lower_bound(list.ids.begin(), list.ids.end(), id);
+    size_t pos = (size_t)(it - list.ids.begin());
+    if (it == list.ids.end() || *it != id) {
+        list.ids.insert(it, id);
+        list.counts.insert(list.counts.begin() + pos, counts);
+    }
+    else {
+        list.counts[pos] = counts;
+    }
+}
+
+void WordIndex::erasePosting(const std::string& term, NoteId id) {
+    auto found = postings.find(term);
+    if (found == postings.end()) return;
+
+    auto& list = found->second;
+    auto it = std::lower_bound(list.ids.begin(), list.ids.end(), id);
+    if (it != list.ids.end() && *it == id) {
+        list.counts.erase(list.counts.begin() + (it - list.ids.begin()));
+        list.ids.erase(it);
+    }
+    if (list.ids.empty()) {
+        postings.erase(found);
+    }
+}
+
+void WordIndex::addLengths(NoteId id, FieldLengths fieldLengths) {
+    eraseLengths(id);
+    lengths[id] = fieldLengths;
+    titleWordTotal += fieldLengths.title;
+    contentWordTotal += fieldLengths.content;
+}
+
+void WordIndex::eraseLengths(NoteId id) {
+    auto found = lengths.find(id);
+    if (found == lengths.end()) return;
+    titleWordTotal -= found->second.title;
+    contentWordTotal -= found->second.content;
+    lengths.erase(found);
+}
+
+// ========== ПОИСК ==========
+
+std::vector<NoteId> WordIndex::find(const std::string& query) const {
+    std::vector<NoteId> result;
+    std::vector<const std::vector<NoteId>*> lists;
+
+    for (const auto& term : tokenize(query, encoding)) {
+        auto found = postings.find(term);
+        if (found == postings.end()) {
+            return result;  // Одного из слов нет ни в одной заметке
+        }
+        lists.push_back(&found->second.ids);
+    }
+    if (lists.empty()) {
+        return result;
+    }
+
+    // Пересечение начинаем с самого короткого списка
+    std::sort(lists.begin(), lists.end(),
+        [](const std::vector<NoteId>* a, const std::vector<NoteId>* b) { return a->size() < b->size(); });
+
+    result = *lists[0];
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        std::vector<NoteId> intersection;
+        std::set_intersection(result.begin(), result.end(),
+            lists[i]->begin(), lists[i]->end(), std::back_inserter(intersection));
+        result.swap(intersection);
+    }
+    return result;
+}
+
+std::vector<ScoredNote> WordIndex::rank(const std::string& query, size_t k, size_t documentCount,
+    const std::function<bool(NoteId)>& isLive) const {
+    std::vector<ScoredNote> heap;
+    if (k == 0 || lengths.empty()) {
+        return heap;
+    }
+
+    // Курсор по списку слова запроса; idf - по числу заметок со словом. Оценка слова
+    // меньше idf * (k1 + 1) при любых частотах - это верхняя граница вклада курсора
+    struct Cursor {
+        const PostingList* list;
+        size_t pos;
+        double idf;
+        double maxScore;
+
+        NoteId current() const {
+            return pos < list->ids.size() ? list->ids[pos] : std::numeric_limits<NoteId>::max();
+        }
+    };
+    // В idf - только живые заметки: надгробия остаются в списках до вычистки индекса
+    const double documents = (double)(std::max)(documentCount, (size_t)1);
+    std::vector<Cursor> cursors;
+    for (const auto& term : tokenize(query, encoding)) {
+        auto found = postings.find(term);
+        if (found == postings.end()) continue;
+        double df = (std::min)((double)found->second.ids.size(), documents);
+        double idf = std::log(1.0 + (documents - df + 0.5) / (df + 0.5));
+        cursors.push_back({ &found->second, 0, idf, idf * (BM25_K1 + 1.0) });
+    }
+
+    // Средние длины полей - по всем проиндексированным заметкам, как и суммы длин
+    const double indexed = (double)lengths.size();
+    const double avgTitle = (std::max)(1.0, (double)titleWordTotal / indexed);
+    const double avgContent = (std::max)(1.0, (double)contentWordTotal / indexed);
+
+    // Лучше - большая оценка, при равенстве меньший идентификатор (порядок не зависит от кучи)
+    auto better = [](const ScoredNote& a, const ScoredNote& b) {
+        return a.score > b.score || (a.score == b.score && a.id < b.id);
+    };
+    heap.reserve(k);
+
+    // WAND: курсоры упорядочены по текущему идентификатору. Опорная заметка - первая,
+    // на которой сумма верхних границ курсоров до неё включительно превышает оценку
+    // худшего результата полной кучи; заметки раньше неё не могут попасть в выдачу,
+    // поэтому отстающие курсоры перескакивают к ней двоичным поиском, не читая записей.
+    // Заметки просматриваются по возрастанию идентификаторов, так что при равной оценке
+    // новая заметка хуже имеющейся - для попадания в кучу граница должна быть строго больше
+    auto byCurrent = [](const Cursor& a, const Cursor& b) { return a.current() < b.current(); };
+    const NoteId exhausted = std::numeric_limits<NoteId>::max();
+    while (true) {
+        std::sort(cursors.begin(), cursors.end(), byCurrent);
+
+        size_t pivot = 0;
+        double bound = 0.0;
+        bool full = heap.size() == k;
+        for (; pivot < cursors.size() && cursors[pivot].current() != exhausted; ++pivot) {
+            bound += cursors[pivot].maxScore;
+            if (!full || bound > heap.front().score) break;
+        }
+        if (pivot == cursors.size() || cursors[pivot].current() == exhausted) break;
+        NoteId pivotId = cursors[pivot].current();
+
+        if (cursors[0].current() != pivotId) {
+            // Перед опорной заметкой ни одна не наберёт нужной оценки: курсор с самым
+            // длинным остатком прыгает к ней (он сильнее всего сокращает просмотр)
+            size_t lagging = 0;
+            for (size_t i = 1; i < pivot; ++i) {
+                if (cursors[i].current() == pivotId) break;
+                if (cursors[i].list->ids.size() - cursors[i].pos > cursors[lagging].list->ids.size() - cursors[lagging].pos) {
+                    lagging = i;
+                }
+            }
+            Cursor& cursor = cursors[lagging];
+            cursor.pos = (size_t)(std::lower_bound(cursor.list->ids.begin() + cursor.pos,
+                cursor.list->ids.end(), pivotId) - cursor.list->ids.begin());
+            continue;
+        }
+
+        // Все курсоры до опорного стоят на ней: оцениваем заметку по всем её словам
+        double score = 0.0;
+        for (auto& cursor : cursors) {
+            if (cursor.current() != pivotId) break;
+            // BM25F: частоты полей нормализуются по своей средней длине и складываются с весами
+            const TermCounts& counts = cursor.list->counts[cursor.pos];
+            double tf = TITLE_WEIGHT * counts.title /
+                (1.0 - BM25_B + BM25_B * counts.titleLength / avgTitle) +
+                counts.content / (1.0 - BM25_B + BM25_B * counts.contentLength / avgContent);
+            score += cursor.idf * tf * (BM25_K1 + 1.0) / (tf + BM25_K1);
+            ++cursor.pos;
+        }
+
+        // Проверка на удаление дороже оценки, поэтому делается только для попадающих в кучу
+        ScoredNote candidate{ pivotId, score };
+        if (heap.size() < k) {
+            if (!isLive(pivotId)) continue;
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+        else if (better(candidate, heap.front())) {
+            if (!isLive(pivotId)) continue;
+            // Вершина кучи - худший из k лучших
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), better);
+    return heap;
+}
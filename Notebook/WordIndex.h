@@ -0,0 +1,113 @@
+// WordIndex.h
+#pragma once
+
+#include "Note.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+
+//     
+struct ScoredNote {
+    NoteId id;
+    double score;
+};
+
+//  WordIndex -      
+//   (  )    
+//  ,    .  
+//     ,    
+//  O( ),   O( ).
+//           
+// ,     -     ( BM25).
+class WordIndex {
+public:
+    //  BM25:  ,   ,  
+    static constexpr double BM25_K1 = 1.2;
+    static constexpr double BM25_B = 0.75;
+    static constexpr double TITLE_WEIGHT = 2.0;
+
+    //      
+    void rebuild(const std::vector<Note>& notes);
+
+    //   ( -  )
+    void add(const Note& note);
+
+    //        
+    void update(const Note& oldNote, const Note& newNote);
+
+    //  ;     
+    void remove(const Note& note);
+
+    //    ,  
+    //          -   Notebook
+    void purge(const std::function<bool(NoteId)>& isRemoved);
+
+    // ,      (  )
+    std::vector<NoteId> find(const std::string& query) const;
+
+    // k     BM25    (   ),  
+    // documentCount -    ( idf); ,   isLive ,
+    // .    WAND: ,      k ,
+    //     ;      k 
+    std::vector<ScoredNote> rank(const std::string& query, size_t k, size_t documentCount,
+        const std::function<bool(NoteId)>& isLive) const;
+
+    //        ( )
+    static std::vector<std::string> tokenize(std::string_view text, TextEncoding encoding = TextEncoding::Cp1251);
+
+    //   ;      (rebuild)
+    void setEncoding(TextEncoding newEncoding) { encoding = newEncoding; }
+
+private:
+    //            (   65535)
+    //     ,       lengths
+    struct TermCounts {
+        uint16_t title = 0;
+        uint16_t content = 0;
+        uint16_t titleLength = 0;
+        uint16_t contentLength = 0;
+    };
+
+    //    :       
+    struct PostingList {
+        std::vector<NoteId> ids;
+        std::vector<TermCounts> counts;
+    };
+
+    //      (    )
+    struct FieldLengths {
+        uint32_t title = 0;
+        uint32_t content = 0;
+    };
+
+    //     
+    struct NoteTerm {
+        std::string term;
+        TermCounts counts;
+    };
+
+    std::unordered_map<std::string, PostingList> postings;
+    std::unordered_map<NoteId, FieldLengths> lengths;
+    uint64_t titleWordTotal = 0;
+    uint64_t contentWordTotal = 0;
+    TextEncoding encoding = TextEncoding::Cp1251;
+
+    //  ,    ;   -  lengths
+    std::vector<NoteTerm> noteTerms(const Note& note, FieldLengths& fieldLengths) const;
+
+    //       ( )
+    static void appendTerms(std::string_view text, TextEncoding encoding, std::vector<std::string>& terms);
+    static void appendTermsUtf8(std::string_view text, std::vector<std::string>& terms);
+
+    //     
+    static void sortUnique(std::vector<std::string>& terms);
+
+    void insertPosting(const std::string& term, NoteId id, TermCounts counts);
+    void erasePosting(const std::string& term, NoteId id);
+
+    void addLengths(NoteId id, FieldLengths fieldLengths);
+    void eraseLengths(NoteId id);
+};